@@ -0,0 +1,528 @@
+//
+//  Hot path, config loading and allocation benchmarks. Built as the plecto_bench target when Google Benchmark is found, or by hand:
+//  cc -O2 -c ../*.c && c++ -O2 -I.. ctrnnBench.cpp *.o -lbenchmark -lbenchmark_main -lpthread
+//
+//  steps/s and configs/s are reported as items per second, time/neuron as seconds per node
+//  update and allocs/op as heap allocations per benchmark iteration.
+//
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ctrnn.h"
+#include "ctrnnf.h"
+#include "ctrnnBank.h"
+#include "ctrnnAdaptive.h"
+#include "ctrnnControlRate.h"
+#include "ctrnnCycle.h"
+#include "ctrnnInternal.h"
+#include "jsonUtils.h"
+
+// Count every heap allocation of the process, including those made by the C library code.
+// Sanitizer runtimes replace malloc themselves, so counting is off under them.
+#if defined(__GLIBC__) && !defined(PLECTO_SANITIZE) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+static std::atomic<long> allocationCount(0);
+
+extern "C" void *malloc(size_t size) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+extern "C" void *calloc(size_t count, size_t size) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+extern "C" void *realloc(void *pointer, size_t size) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+static long allocations(){
+    return allocationCount.load(std::memory_order_relaxed);
+}
+#else
+// Allocations are not counted here, allocs/op reads 0.
+static long allocations(){
+    return 0;
+}
+#endif
+
+static const char *levelNames[] = {"auto", "scalar", "sse2", "avx2", "avx512"};
+
+// Network sizes as {input nodes, hidden nodes}, from the Plecto API network up to large ones.
+static const std::vector<std::vector<int64_t>> networkSizes = {{4, 6}, {4, 16}, {8, 32}, {16, 64}, {32, 128}, {64, 256}};
+
+// Deterministic values in [0, 1), the range configs are serialised in.
+static double nextValue(unsigned int &seed){
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0;
+}
+static void fillConfigNode(ConfigNode *node, int numWeights, unsigned int &seed){
+    node->gain = nextValue(seed);
+    node->bias = nextValue(seed);
+    node->t = nextValue(seed);
+    node->sineCoefficient = nextValue(seed);
+    node->frequencyMultiplier = nextValue(seed);
+    node->weights = (double *)malloc(sizeof(double) * numWeights);
+    for(int w = 0; w < numWeights; w++){
+        node->weights[w] = nextValue(seed);
+    }
+}
+// Build a synthetic config. Release it with destroyConfigDesc.
+static void buildSyntheticConfig(ConfigDesc *configDesc, int numInputNodes, int numHiddenNodes, unsigned int seed){
+    initConfigDesc(configDesc, numInputNodes, numHiddenNodes);
+    for(int node = 0; node < numInputNodes; node++){
+        fillConfigNode(&configDesc->inputNodes[node], 1, seed);
+    }
+    for(int node = 0; node < numHiddenNodes; node++){
+        fillConfigNode(&configDesc->hiddenNodes[node], numInputNodes + numHiddenNodes, seed);
+    }
+}
+static void appendConfigNode(std::string &json, int numWeights, unsigned int &seed){
+    char number[32];
+    json += "{";
+    static const char *keys[] = {"bias", "gain", "t", "sineCoefficient", "frequencyMultiplier"};
+    for(const char *key : keys){
+        snprintf(number, sizeof(number), "%.6f", nextValue(seed));
+        json += std::string("\"") + key + "\": " + number + ", ";
+    }
+    json += "\"w\": [";
+    for(int w = 0; w < numWeights; w++){
+        snprintf(number, sizeof(number), w ? ", %.6f" : "%.6f", nextValue(seed));
+        json += number;
+    }
+    json += "]}";
+}
+// Serialise a synthetic profile of numConfigs Plecto API sized configs.
+static std::string buildSyntheticProfile(int numConfigs){
+    const int numInputNodes = 4;
+    const int numHiddenNodes = 6;
+    unsigned int seed = 12345;
+    std::string json = "{\"total\": " + std::to_string(numConfigs) + ", \"configs\": [";
+    for(int config = 0; config < numConfigs; config++){
+        json += config ? ", " : "";
+        json += "{\"tag\": \"config" + std::to_string(config) + "\", \"iNs\": 4, \"hNs\": 6, \"inputNodes\": [";
+        for(int node = 0; node < numInputNodes; node++){
+            json += node ? ", " : "";
+            appendConfigNode(json, 1, seed);
+        }
+        json += "], \"hiddenNodes\": [";
+        for(int node = 0; node < numHiddenNodes; node++){
+            json += node ? ", " : "";
+            appendConfigNode(json, numInputNodes + numHiddenNodes, seed);
+        }
+        json += "]}";
+    }
+    json += "]}";
+    return json;
+}
+// A synthetic config, released when it goes out of scope.
+struct SyntheticConfig {
+    ConfigDesc configDesc;
+    SyntheticConfig(int numInputNodes, int numHiddenNodes, unsigned int seed){
+        buildSyntheticConfig(&configDesc, numInputNodes, numHiddenNodes, seed);
+    }
+    ~SyntheticConfig(){
+        destroyConfigDesc(&configDesc);
+    }
+    SyntheticConfig(const SyntheticConfig &) = delete;
+    SyntheticConfig &operator=(const SyntheticConfig &) = delete;
+};
+// A CTRNN built from a synthetic config, destroyed with it. Inputs start at 0 until fed.
+struct SyntheticNetwork : SyntheticConfig {
+    CTRNN ctrnn{};
+    SyntheticNetwork(int numInputNodes, int numHiddenNodes, unsigned int seed, double timeStep) : SyntheticConfig(numInputNodes, numHiddenNodes, seed){
+        initialiseCTRNN(&ctrnn, &configDesc, timeStep);
+    }
+    ~SyntheticNetwork(){
+        destroyCTRNN(&ctrnn);
+    }
+    // Feed value to every input.
+    void feed(double value){
+        std::vector<double> inputs(ctrnn.numInputNodes, value);
+        feedCTRNNInputs(&ctrnn, inputs.data());
+    }
+};
+// Time body once per iteration and report the heap allocations it makes per iteration.
+template<typename Body> static void timeIterations(benchmark::State &state, Body body){
+    long before = allocations();
+    for(auto _ : state){
+        body();
+        benchmark::ClobberMemory();
+    }
+    state.counters["allocs/op"] = benchmark::Counter((double)(allocations() - before), benchmark::Counter::kAvgIterations);
+}
+// Report seconds per node update for iterations that each update numNodes nodes numUpdates times.
+static void reportNeuronTime(benchmark::State &state, int numNodes, int numUpdates){
+    state.counters["time/neuron"] = benchmark::Counter((double)state.iterations() * numUpdates * numNodes, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+// Register a step benchmark for every network size with the scalar and best kernels.
+static void applyNetworkSizes(benchmark::internal::Benchmark *benchmark){
+    benchmark->ArgNames({"inputs", "hidden", "level"});
+    for(const std::vector<int64_t> &size : networkSizes){
+        benchmark->Args({size[0], size[1], CTRNN_KERNELS_SCALAR});
+        benchmark->Args({size[0], size[1], CTRNN_KERNELS_AUTO});
+    }
+}
+// Steps of a network of the benchmark's size and kernel level, each taken by step.
+template<typename Step> static void timeNetworkSteps(benchmark::State &state, Step step){
+    SyntheticNetwork network((int)state.range(0), (int)state.range(1), 1, 0.01);
+    selectCTRNNKernels(&network.ctrnn, (CTRNNKernelLevel)state.range(2));
+    network.feed(0.5);
+    timeIterations(state, [&](){
+        step(&network.ctrnn);
+    });
+    state.SetItemsProcessed(state.iterations());
+    reportNeuronTime(state, network.ctrnn.numNodes, 1);
+    state.SetLabel(levelNames[network.ctrnn.kernels->level]);
+}
+
+static void BM_UpdateCTRNN(benchmark::State &state){
+    timeNetworkSteps(state, updateCTRNN);
+}
+BENCHMARK(BM_UpdateCTRNN)->Apply(applyNetworkSizes);
+
+// The header-inline step, stepped from this translation unit.
+static void BM_StepCTRNN(benchmark::State &state){
+    timeNetworkSteps(state, [](CTRNN *ctrnn){
+        stepCTRNN(ctrnn);
+    });
+}
+BENCHMARK(BM_StepCTRNN)->Apply(applyNetworkSizes);
+
+// Steps of a network resting on a fixed point, with freezing off (freeze 0) or on (freeze 1).
+// frozen reads 1 when the network froze before timing.
+static void BM_FreezeCTRNN(benchmark::State &state){
+    SyntheticNetwork network((int)state.range(0), (int)state.range(1), 1, 0.01);
+    CTRNN *ctrnn = &network.ctrnn;
+    if(state.range(2)){
+        setCTRNNFreeze(ctrnn, 1e-4, 64);
+    }
+    network.feed(0.5);
+    for(int step = 0; step < 100000 && !ctrnn->frozen; step++){
+        updateCTRNN(ctrnn);
+    }
+    state.counters["frozen"] = ctrnn->frozen;
+    timeIterations(state, [&](){
+        updateCTRNN(ctrnn);
+    });
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FreezeCTRNN)->ArgNames({"inputs", "hidden", "freeze"})->ArgsProduct({{4}, {6}, {0, 1}});
+
+// Audio-rate output frames rendered by stepping every interval samples, items are samples.
+static void BM_RenderControlRate(benchmark::State &state){
+    const int numSamples = 256;
+    SyntheticNetwork network(4, 6, 1, 0.01);
+    CTRNNControlRate control{};
+    initialiseCTRNNControlRate(&control, &network.ctrnn, 0.0001, (int)state.range(0), 6, (CTRNNInterpolation)state.range(1));
+    std::vector<double> outputs(numSamples * 6);
+    timeIterations(state, [&](){
+        renderCTRNNControlRateBlock(&control, NULL, 0, outputs.data(), CTRNN_OUTPUT_INTERLEAVED, numSamples);
+    });
+    state.SetItemsProcessed(state.iterations() * numSamples);
+    destroyCTRNNControlRate(&control);
+}
+BENCHMARK(BM_RenderControlRate)->ArgNames({"interval", "interpolation"})->ArgsProduct({{1, 16, 64}, {CTRNN_INTERPOLATE_LINEAR, CTRNN_INTERPOLATE_HERMITE, CTRNN_INTERPOLATE_BLEP}});
+
+// Synthetic config seed that settles into a cycle of about 55 steps.
+static const unsigned int cyclingSeed = 4;
+
+// Steps of a network that has settled into a cycle, integrated live (cycle 0) or played back from
+// the captured period (cycle 1). playing reads 1 when the cycle was captured before timing.
+static void BM_RenderCycle(benchmark::State &state){
+    const int numSteps = 256;
+    SyntheticNetwork network(4, 6, cyclingSeed, 0.01);
+    CTRNNCycle cycle{};
+    initialiseCTRNNCycle(&cycle, &network.ctrnn, 6, 4096, 1e-3);
+    std::vector<double> outputs(numSteps * 6);
+    for(int block = 0; block < 1000 && cycle.state != CTRNN_CYCLE_PLAYING; block++){
+        renderCTRNNCycleBlock(&cycle, NULL, 0, outputs.data(), CTRNN_OUTPUT_INTERLEAVED, numSteps);
+    }
+    state.counters["playing"] = cycle.state == CTRNN_CYCLE_PLAYING;
+    timeIterations(state, [&](){
+        if(state.range(0)){
+            renderCTRNNCycleBlock(&cycle, NULL, 0, outputs.data(), CTRNN_OUTPUT_INTERLEAVED, numSteps);
+        } else {
+            renderCTRNNBlock(&network.ctrnn, NULL, 0, outputs.data(), 6, CTRNN_OUTPUT_INTERLEAVED, numSteps);
+        }
+    });
+    state.SetItemsProcessed(state.iterations() * numSteps);
+    destroyCTRNNCycle(&cycle);
+}
+BENCHMARK(BM_RenderCycle)->ArgName("cycle")->Arg(0)->Arg(1);
+
+// Integrators of BM_Integrator, in CTRNNIntegrator order.
+static const char *integratorNames[] = {"euler", "exponential", "heun", "rk4"};
+
+// Synthetic config seed slow enough at timesteps up to 0.01 for the integrators' errors to differ.
+static const unsigned int smoothSeed = 21;
+
+// Largest difference in any hidden output between a network stepped with integrator at timeStep
+// and an RK4 reference at a far smaller timestep, sampled every 0.1 time units for 2 time units.
+// Both start from the outputs of their start state, so the error is the integrator's alone.
+static double integratorError(CTRNNIntegrator integrator, double timeStep){
+    const double referenceTimeStep = 0.0001;
+    const int numSamples = 20;
+    SyntheticNetwork network(4, 6, smoothSeed, timeStep);
+    SyntheticNetwork reference(4, 6, smoothSeed, referenceTimeStep);
+    selectCTRNNIntegrator(&network.ctrnn, integrator);
+    selectCTRNNIntegrator(&reference.ctrnn, CTRNN_INTEGRATE_RK4);
+    network.feed(0.5);
+    reference.feed(0.5);
+    evaluateCTRNNOutput(&network.ctrnn, network.ctrnn.y, network.ctrnn.output);
+    evaluateCTRNNOutput(&reference.ctrnn, reference.ctrnn.y, reference.ctrnn.output);
+    double outputs[6], referenceOutputs[6];
+    double error = 0;
+    for(int sample = 0; sample < numSamples; sample++){
+        for(int step = 0; step < (int)(0.1 / timeStep + 0.5); step++){
+            updateCTRNN(&network.ctrnn);
+        }
+        for(int step = 0; step < (int)(0.1 / referenceTimeStep + 0.5); step++){
+            updateCTRNN(&reference.ctrnn);
+        }
+        getCTRNNOutput(&network.ctrnn, outputs, 6);
+        getCTRNNOutput(&reference.ctrnn, referenceOutputs, 6);
+        for(int node = 0; node < 6; node++){
+            error = std::max(error, std::fabs(outputs[node] - referenceOutputs[node]));
+        }
+    }
+    return error;
+}
+
+// 256 steps of a network with each integrator, timestep in thousandths. Items are simulated
+// time units, so integrators compare at equal cost per unit of time. error is the largest output
+// difference from a fine RK4 reference, measured before timing.
+static void BM_Integrator(benchmark::State &state){
+    CTRNNIntegrator integrator = (CTRNNIntegrator)state.range(0);
+    double timeStep = state.range(1) / 1000.0;
+    const int numSteps = 256;
+    state.SetLabel(integratorNames[integrator]);
+    state.counters["error"] = integratorError(integrator, timeStep);
+    SyntheticNetwork network(4, 6, smoothSeed, timeStep);
+    selectCTRNNIntegrator(&network.ctrnn, integrator);
+    network.feed(0.5);
+    evaluateCTRNNOutput(&network.ctrnn, network.ctrnn.y, network.ctrnn.output);
+    std::vector<double> outputs(numSteps * 6);
+    timeIterations(state, [&](){
+        renderCTRNNBlock(&network.ctrnn, NULL, 0, outputs.data(), 6, CTRNN_OUTPUT_INTERLEAVED, numSteps);
+    });
+    state.counters["timeUnits"] = benchmark::Counter(state.iterations() * numSteps * timeStep, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Integrator)->ArgNames({"integrator", "timestep"})->ArgsProduct({{CTRNN_INTEGRATE_EULER, CTRNN_INTEGRATE_EXPONENTIAL, CTRNN_INTEGRATE_HEUN, CTRNN_INTEGRATE_RK4}, {1, 5, 10}});
+
+// 256 outputs, 0.01 time units apart, of a network stepped from its reset state with forward Euler
+// (tolerance 0) or adaptively to a tolerance of 10^-tolerance. error is the largest output difference
+// from a fine RK4 reference, measured before timing, and evaluations the network evaluations per output.
+static void BM_RenderAdaptive(benchmark::State &state){
+    const int numSteps = 256;
+    const double timeStep = 0.01;
+    const double referenceTimeStep = 0.0001;
+    double tolerance = std::pow(10.0, -(double)state.range(0));
+    SyntheticNetwork network(4, 6, smoothSeed, timeStep);
+    SyntheticNetwork reference(4, 6, smoothSeed, referenceTimeStep);
+    CTRNN *ctrnn = &network.ctrnn;
+    selectCTRNNIntegrator(&reference.ctrnn, CTRNN_INTEGRATE_RK4);
+    network.feed(0.5);
+    reference.feed(0.5);
+    std::vector<double> outputs(numSteps * 6);
+    double referenceOutputs[6];
+    CTRNNAdaptive adaptive{};
+    initialiseCTRNNAdaptive(&adaptive, ctrnn, 6, tolerance, 1.0);
+    // Steps from the reset state and its outputs, by forward Euler or adaptively.
+    auto render = [&](){
+        resetCTRNN(ctrnn);
+        evaluateCTRNNOutput(ctrnn, ctrnn->y, ctrnn->output);
+        if(state.range(0)){
+            resetCTRNNAdaptive(&adaptive);
+            renderCTRNNAdaptiveBlock(&adaptive, NULL, 0, outputs.data(), CTRNN_OUTPUT_INTERLEAVED, numSteps);
+        } else {
+            renderCTRNNBlock(ctrnn, NULL, 0, outputs.data(), 6, CTRNN_OUTPUT_INTERLEAVED, numSteps);
+        }
+    };
+    render();
+    resetCTRNN(&reference.ctrnn);
+    evaluateCTRNNOutput(&reference.ctrnn, reference.ctrnn.y, reference.ctrnn.output);
+    double error = 0;
+    for(int step = 0; step < numSteps; step++){
+        for(int referenceStep = 0; referenceStep < (int)(timeStep / referenceTimeStep + 0.5); referenceStep++){
+            updateCTRNN(&reference.ctrnn);
+        }
+        getCTRNNOutput(&reference.ctrnn, referenceOutputs, 6);
+        for(int node = 0; node < 6; node++){
+            error = std::max(error, std::fabs(outputs[step * 6 + node] - referenceOutputs[node]));
+        }
+    }
+    state.counters["error"] = error;
+    state.counters["evaluations"] = state.range(0) ? (double)adaptive.evaluations / numSteps : 1;
+    timeIterations(state, render);
+    state.SetItemsProcessed(state.iterations() * numSteps);
+    destroyCTRNNAdaptive(&adaptive);
+}
+BENCHMARK(BM_RenderAdaptive)->ArgName("tolerance")->Arg(0)->Arg(3)->Arg(4)->Arg(5);
+
+// Steps until the float engine's outputs drift more than divergenceThreshold from the double engine's.
+static const int maxDivergenceSteps = 4800;
+static const double divergenceThreshold = 1e-3;
+
+static int divergenceStep(ConfigDesc *configDesc){
+    CTRNN ctrnn{};
+    CTRNNf ctrnnf{};
+    initialiseCTRNN(&ctrnn, configDesc, 0.01);
+    initialiseCTRNNf(&ctrnnf, configDesc, 0.01f);
+    std::vector<double> inputs(configDesc->numInputNodes, 0.5), outputs(configDesc->numHiddenNodes);
+    std::vector<float> inputsf(configDesc->numInputNodes, 0.5f), outputsf(configDesc->numHiddenNodes);
+    feedCTRNNInputs(&ctrnn, inputs.data());
+    feedCTRNNfInputs(&ctrnnf, inputsf.data());
+    int step;
+    for(step = 0; step < maxDivergenceSteps; step++){
+        updateCTRNN(&ctrnn);
+        updateCTRNNf(&ctrnnf);
+        getCTRNNOutput(&ctrnn, outputs.data(), configDesc->numHiddenNodes);
+        getCTRNNfOutput(&ctrnnf, outputsf.data(), configDesc->numHiddenNodes);
+        int node;
+        for(node = 0; node < configDesc->numHiddenNodes && std::fabs(outputs[node] - outputsf[node]) <= divergenceThreshold; node++){
+        }
+        if(node < configDesc->numHiddenNodes){
+            break;
+        }
+    }
+    destroyCTRNN(&ctrnn);
+    destroyCTRNNf(&ctrnnf);
+    return step;
+}
+
+static void BM_UpdateCTRNNf(benchmark::State &state){
+    int numInputNodes = (int)state.range(0);
+    SyntheticConfig config(numInputNodes, (int)state.range(1), 1);
+    CTRNNf ctrnn{};
+    initialiseCTRNNf(&ctrnn, &config.configDesc, 0.01f);
+    selectCTRNNfKernels(&ctrnn, (CTRNNKernelLevel)state.range(2));
+    std::vector<float> inputs(numInputNodes, 0.5f);
+    feedCTRNNfInputs(&ctrnn, inputs.data());
+    timeIterations(state, [&](){
+        updateCTRNNf(&ctrnn);
+    });
+    state.SetItemsProcessed(state.iterations());
+    reportNeuronTime(state, ctrnn.numNodes, 1);
+    // Chaotic networks amplify rounding, so this is where float and double part ways rather than an error bound. The bound is checked by c/tests/ctrnnfTest.c.
+    state.counters["divergenceStep"] = divergenceStep(&config.configDesc);
+    state.SetLabel(levelNames[ctrnn.kernels->level]);
+    destroyCTRNNf(&ctrnn);
+}
+BENCHMARK(BM_UpdateCTRNNf)->Apply(applyNetworkSizes);
+
+// Every instance steps together, so items are instance steps.
+static void BM_UpdateCTRNNBank(benchmark::State &state){
+    int numInputNodes = (int)state.range(0);
+    int numHiddenNodes = (int)state.range(1);
+    int numInstances = (int)state.range(2);
+    CTRNNBank bank{};
+    initialiseCTRNNBank(&bank, numInstances, numInputNodes, numHiddenNodes, 0.01);
+    std::vector<std::unique_ptr<SyntheticConfig>> configs;
+    for(int instance = 0; instance < numInstances; instance++){
+        configs.emplace_back(new SyntheticConfig(numInputNodes, numHiddenNodes, instance + 1));
+        assignCTRNNBankConfig(&bank, instance, &configs.back()->configDesc);
+    }
+    timeIterations(state, [&](){
+        updateCTRNNBank(&bank);
+    });
+    state.SetItemsProcessed(state.iterations() * numInstances);
+    reportNeuronTime(state, numInputNodes + numHiddenNodes, numInstances);
+    state.SetLabel(levelNames[bank.kernels->level]);
+    destroyCTRNNBank(&bank);
+}
+BENCHMARK(BM_UpdateCTRNNBank)->ArgNames({"inputs", "hidden", "instances"})->Args({4, 6, 16})->Args({4, 16, 16})->Args({8, 32, 64});
+
+static void BM_FeedAndGetOutput(benchmark::State &state){
+    SyntheticNetwork network(4, 6, 1, 0.01);
+    double inputs[4] = {0.1, 0.2, 0.3, 0.4};
+    double outputs[6];
+    timeIterations(state, [&](){
+        feedCTRNNInputs(&network.ctrnn, inputs);
+        getCTRNNOutput(&network.ctrnn, outputs, 6);
+        benchmark::DoNotOptimize(outputs);
+    });
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FeedAndGetOutput);
+
+// How a profile is rendered by BM_RenderConfigs.
+enum RenderMode {
+    RENDER_EAGER = 0,
+    RENDER_LAZY,
+    RENDER_PARALLEL,
+    RENDER_PARALLEL_MAPPED
+};
+static const char *renderModeNames[] = {"eager", "lazy", "parallel", "parallelMapped"};
+
+static void BM_RenderConfigs(benchmark::State &state){
+    int numConfigs = (int)state.range(0);
+    RenderMode mode = (RenderMode)state.range(1);
+    std::string json = buildSyntheticProfile(numConfigs);
+    timeIterations(state, [&](){
+        ConfigData configData = {NULL, 0, 0, NULL, NULL, NULL, 0};
+        if(mode == RENDER_LAZY){
+            renderCTRNNConfigsLazy(&configData, &json[0]);
+        } else if(mode == RENDER_PARALLEL_MAPPED){
+            renderAndMapCTRNNConfigsParallel(&configData, &json[0], 0);
+        } else if(mode == RENDER_PARALLEL){
+            renderCTRNNConfigsParallel(&configData, &json[0], 0);
+        } else {
+            renderCTRNNConfigs(&configData, &json[0]);
+        }
+        benchmark::DoNotOptimize(configData.configDescriptions);
+        state.PauseTiming();
+        destroyConfigData(&configData);
+        state.ResumeTiming();
+    });
+    state.SetItemsProcessed(state.iterations() * numConfigs);
+    state.SetBytesProcessed(state.iterations() * json.size());
+    state.SetLabel(renderModeNames[mode]);
+}
+BENCHMARK(BM_RenderConfigs)->ArgNames({"configs", "mode"})->ArgsProduct({{1, 100, 10000, 100000}, {RENDER_EAGER, RENDER_LAZY, RENDER_PARALLEL, RENDER_PARALLEL_MAPPED}})->Unit(benchmark::kMillisecond);
+
+// How a network is built by BM_InitialiseDestroy.
+enum InitialiseMode {
+    INITIALISE_OWNED = 0,
+    INITIALISE_IN_PLACE,
+    INITIALISE_PREMAPPED,
+    INITIALISE_INSTANCE
+};
+static const char *initialiseModeNames[] = {"owned", "inPlace", "premapped", "instance"};
+
+static void BM_InitialiseDestroy(benchmark::State &state){
+    SyntheticConfig config((int)state.range(0), (int)state.range(1), 1);
+    ConfigDesc *configDesc = &config.configDesc;
+    InitialiseMode mode = (InitialiseMode)state.range(2);
+    if(mode == INITIALISE_PREMAPPED){
+        mapCTRNNConfig(configDesc);
+    }
+    CTRNNDefinition *definition = createCTRNNDefinition(configDesc);
+    void *memory = malloc(ctrnnRequiredBytes(configDesc));
+    CTRNN ctrnn{};
+    timeIterations(state, [&](){
+        if(mode == INITIALISE_IN_PLACE){
+            initialiseCTRNNInPlace(&ctrnn, configDesc, 0.01, memory);
+        } else if(mode == INITIALISE_INSTANCE){
+            initialiseCTRNNInstanceInPlace(&ctrnn, definition, 0.01, memory);
+        } else {
+            initialiseCTRNN(&ctrnn, configDesc, 0.01);
+        }
+        benchmark::DoNotOptimize(ctrnn.weights);
+        destroyCTRNN(&ctrnn);
+    });
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(initialiseModeNames[mode]);
+    free(memory);
+    releaseCTRNNDefinition(definition);
+}
+BENCHMARK(BM_InitialiseDestroy)->ArgNames({"inputs", "hidden", "mode"})->ArgsProduct({{4}, {6, 64}, {INITIALISE_OWNED, INITIALISE_IN_PLACE, INITIALISE_PREMAPPED, INITIALISE_INSTANCE}});
@@ -0,0 +1,50 @@
+//
+//  Throughput and max error of each transfer function mode. Built as the plecto_transfer_bench target when Google Benchmark is found, or by hand:
+//  cc -O2 -c ../ctrnnKernels.c ../mapParams.c && c++ -O2 -I.. transferBench.cpp ctrnnKernels.o mapParams.o -lbenchmark -lbenchmark_main -lpthread
+//
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+#include "ctrnnKernels.h"
+#include "mapParams.h"
+
+static const char *levelNames[] = {"auto", "scalar", "sse2", "avx2", "avx512"};
+static const char *modeNames[] = {"accurate", "exact", "fast", "table"};
+
+// Activations, transfer coefficients and frequency multipliers over the ranges mapped configs reach.
+static void fillTransferInputs(std::vector<double> &activation, std::vector<double> &tanhCoefficient, std::vector<double> &sineCoefficient, std::vector<double> &frequencyMultiplier){
+    unsigned int seed = 12345;
+    for(size_t i = 0; i < activation.size(); i++){
+        seed = seed * 1664525u + 1013904223u;
+        activation[i] = ((seed >> 8) / 16777216.0 - 0.5) * 80.0;
+        sineCoefficient[i] = (i % 7) / 6.0;
+        tanhCoefficient[i] = 1 - sineCoefficient[i];
+        frequencyMultiplier[i] = (double)(i % 11);
+    }
+}
+
+static void BM_SineTransfer(benchmark::State &state){
+    const CTRNNKernels *kernels = getCTRNNKernels((CTRNNKernelLevel)state.range(0));
+    CTRNNTransferMode mode = (CTRNNTransferMode)state.range(1);
+    int n = (int)state.range(2);
+    CTRNNSineTransfer transfer = getCTRNNSineTransfer(kernels, mode);
+    std::vector<double> activation(n), tanhCoefficient(n), sineCoefficient(n), frequencyMultiplier(n), out(n);
+    fillTransferInputs(activation, tanhCoefficient, sineCoefficient, frequencyMultiplier);
+    for(auto _ : state){
+        transfer(activation.data(), tanhCoefficient.data(), sineCoefficient.data(), frequencyMultiplier.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    double maxError = 0.0;
+    for(int i = 0; i < n; i++){
+        maxError = std::fmax(maxError, std::fabs(out[i] - sineTransferFunction(activation[i], sineCoefficient[i], frequencyMultiplier[i])));
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.counters["maxError"] = maxError;
+    state.SetLabel(std::string(levelNames[kernels->level]) + "/" + modeNames[mode]);
+}
+BENCHMARK(BM_SineTransfer)->ArgsProduct({
+    {CTRNN_KERNELS_SCALAR, CTRNN_KERNELS_AVX2},
+    {CTRNN_TRANSFER_ACCURATE, CTRNN_TRANSFER_EXACT, CTRNN_TRANSFER_FAST, CTRNN_TRANSFER_TABLE},
+    {16, 1024}
+});
@@ -0,0 +1,342 @@
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include "configBinary.h"
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// File layout, in native byte order:
+//   header
+//   one record per config
+//   one node parameter block per node, input nodes of a config before its hidden nodes
+//   weights, per config: the input node weights then the row-major hidden weight matrix,
+//   starting on a 64 byte boundary
+//   NUL terminated tags
+// Node parameters are stored as parsed, before mapParams is applied (flags is 0).
+
+#define CONFIG_BINARY_ALIGNMENT 64
+
+typedef struct ConfigBinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t numConfigs;
+    uint64_t numNodes;
+    uint64_t configOffset;
+    uint64_t nodeOffset;
+    uint64_t weightOffset;
+    uint64_t tagOffset;
+    uint64_t fileSize;
+} ConfigBinaryHeader;
+
+typedef struct ConfigBinaryRecord {
+    uint32_t numInputNodes;
+    uint32_t numHiddenNodes;
+    uint64_t firstNode;
+    uint64_t weightOffset; // Relative to the header's weightOffset.
+    uint64_t tagOffset; // Relative to the header's tagOffset.
+} ConfigBinaryRecord;
+
+typedef struct ConfigBinaryNode {
+    double gain;
+    double bias;
+    double t;
+    double sineCoefficient;
+    double frequencyMultiplier;
+} ConfigBinaryNode;
+
+static const char configBinaryMagic[4] = {'P', 'L', 'C', 'B'};
+
+// Round an offset up to the next aligned boundary.
+static uint64_t alignOffset(uint64_t offset){
+    return (offset + CONFIG_BINARY_ALIGNMENT - 1) / CONFIG_BINARY_ALIGNMENT * CONFIG_BINARY_ALIGNMENT;
+}
+// Bytes of weights stored for a config.
+static uint64_t configWeightBytes(uint64_t numInputNodes, uint64_t numHiddenNodes){
+    return sizeof(double) * (numInputNodes + numHiddenNodes * (numInputNodes + numHiddenNodes));
+}
+// Pad the file with zeros up to offset.
+static int padTo(FILE *file, uint64_t *position, uint64_t offset){
+    static const char zeros[CONFIG_BINARY_ALIGNMENT] = {0};
+    while(*position < offset){
+        size_t count = offset - *position < CONFIG_BINARY_ALIGNMENT ? (size_t)(offset - *position) : CONFIG_BINARY_ALIGNMENT;
+        if(fwrite(zeros, 1, count, file) != count){
+            return 0;
+        }
+        *position += count;
+    }
+    return 1;
+}
+// Write a node's parameters.
+static int writeNode(FILE *file, ConfigNode *node){
+    ConfigBinaryNode binaryNode = {node->gain, node->bias, node->t, node->sineCoefficient, node->frequencyMultiplier};
+    return fwrite(&binaryNode, sizeof(binaryNode), 1, file) == 1;
+}
+// Write configData to a binary config file. Returns 0 if the file cannot be written.
+int writeConfigBinary(ConfigData *configData, const char *path){
+    FILE *file = fopen(path, "wb");
+    if(!file){
+        return 0;
+    }
+    ConfigBinaryHeader header;
+    uint64_t weightBytes = 0;
+    uint64_t tagBytes = 0;
+    int config;
+    int node;
+    int ok = 1;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, configBinaryMagic, sizeof(header.magic));
+    header.version = CONFIG_BINARY_VERSION;
+    header.numConfigs = (uint32_t)configData->numConfigs;
+    for(config = 0; config < configData->numConfigs; config++){
+        ConfigDesc *configDesc = &configData->configDescriptions[config];
+        header.numNodes += configDesc->numInputNodes + configDesc->numHiddenNodes;
+        weightBytes = alignOffset(weightBytes) + configWeightBytes(configDesc->numInputNodes, configDesc->numHiddenNodes);
+        tagBytes += (configDesc->tag ? strlen(configDesc->tag) : 0) + 1;
+    }
+    header.configOffset = sizeof(ConfigBinaryHeader);
+    header.nodeOffset = header.configOffset + sizeof(ConfigBinaryRecord) * header.numConfigs;
+    header.weightOffset = alignOffset(header.nodeOffset + sizeof(ConfigBinaryNode) * header.numNodes);
+    header.tagOffset = header.weightOffset + weightBytes;
+    header.fileSize = header.tagOffset + tagBytes;
+    ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    // Config records.
+    uint64_t firstNode = 0;
+    uint64_t weightOffset = 0;
+    uint64_t tagOffset = 0;
+    for(config = 0; ok && config < configData->numConfigs; config++){
+        ConfigDesc *configDesc = &configData->configDescriptions[config];
+        ConfigBinaryRecord record;
+        weightOffset = alignOffset(weightOffset);
+        record.numInputNodes = (uint32_t)configDesc->numInputNodes;
+        record.numHiddenNodes = (uint32_t)configDesc->numHiddenNodes;
+        record.firstNode = firstNode;
+        record.weightOffset = weightOffset;
+        record.tagOffset = tagOffset;
+        ok = fwrite(&record, sizeof(record), 1, file) == 1;
+        firstNode += configDesc->numInputNodes + configDesc->numHiddenNodes;
+        weightOffset += configWeightBytes(configDesc->numInputNodes, configDesc->numHiddenNodes);
+        tagOffset += (configDesc->tag ? strlen(configDesc->tag) : 0) + 1;
+    }
+    // Node parameters.
+    for(config = 0; ok && config < configData->numConfigs; config++){
+        ConfigDesc *configDesc = &configData->configDescriptions[config];
+        for(node = 0; ok && node < configDesc->numInputNodes; node++){
+            ok = writeNode(file, &configDesc->inputNodes[node]);
+        }
+        for(node = 0; ok && node < configDesc->numHiddenNodes; node++){
+            ok = writeNode(file, &configDesc->hiddenNodes[node]);
+        }
+    }
+    // Weights.
+    uint64_t position = header.nodeOffset + sizeof(ConfigBinaryNode) * header.numNodes;
+    for(config = 0; ok && config < configData->numConfigs; config++){
+        ConfigDesc *configDesc = &configData->configDescriptions[config];
+        size_t numNodes = configDesc->numInputNodes + configDesc->numHiddenNodes;
+        ok = padTo(file, &position, alignOffset(position));
+        for(node = 0; ok && node < configDesc->numInputNodes; node++){
+            ok = fwrite(configDesc->inputNodes[node].weights, sizeof(double), 1, file) == 1;
+        }
+        for(node = 0; ok && node < configDesc->numHiddenNodes; node++){
+            ok = fwrite(configDesc->hiddenNodes[node].weights, sizeof(double), numNodes, file) == numNodes;
+        }
+        position += configWeightBytes(configDesc->numInputNodes, configDesc->numHiddenNodes);
+    }
+    // Tags.
+    for(config = 0; ok && config < configData->numConfigs; config++){
+        const char *tag = configData->configDescriptions[config].tag ? configData->configDescriptions[config].tag : "";
+        ok = fwrite(tag, 1, strlen(tag) + 1, file) == strlen(tag) + 1;
+    }
+    if(fclose(file) != 0){
+        ok = 0;
+    }
+    return ok;
+}
+// Map a whole file privately, so writes to the mapping stay in memory. Returns NULL if it cannot be opened.
+static void *mapFile(const char *path, size_t *size){
+#if defined(_WIN32)
+    // No mmap, so the file is read into one allocation instead.
+    FILE *file = fopen(path, "rb");
+    if(!file){
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void *data = length > 0 ? malloc((size_t)length) : NULL;
+    if(data && fread(data, 1, (size_t)length, file) != (size_t)length){
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+#else
+    int descriptor = open(path, O_RDONLY);
+    if(descriptor < 0){
+        return NULL;
+    }
+    struct stat status;
+    void *data = NULL;
+    if(fstat(descriptor, &status) == 0 && status.st_size > 0){
+        data = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        if(data == MAP_FAILED){
+            data = NULL;
+        }
+        *size = (size_t)status.st_size;
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(descriptor);
+    return data;
+#endif
+}
+// Release a mapping made by mapFile.
+static void unmapFile(void *data, size_t size){
+#if defined(_WIN32)
+    (void)size;
+    free(data);
+#else
+    munmap(data, size);
+#endif
+}
+// Whether count items of itemSize bytes fit between offset and limit. Written so that nothing wraps.
+static int fitsBetween(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t limit){
+    return offset <= limit && count <= (limit - offset) / itemSize;
+}
+// Whether a config's weights fit between offset and limit, without computing their size first.
+static int weightsFit(uint64_t offset, uint64_t numInputNodes, uint64_t numHiddenNodes, uint64_t limit){
+    if(offset > limit){
+        return 0;
+    }
+    uint64_t available = (limit - offset) / sizeof(double);
+    uint64_t numNodes = numInputNodes + numHiddenNodes;
+    if(numInputNodes > available){
+        return 0;
+    }
+    return numHiddenNodes == 0 || numHiddenNodes <= (available - numInputNodes) / numNodes;
+}
+// Check a mapped file's header and records so that every view built from it stays inside the file,
+// and that the views fit in memory and in the int counts of ConfigDesc.
+static int validateConfigBinary(const char *data, size_t size){
+    const ConfigBinaryHeader *header = (const ConfigBinaryHeader *)data;
+    if(size < sizeof(ConfigBinaryHeader) || memcmp(header->magic, configBinaryMagic, sizeof(header->magic)) != 0){
+        return 0;
+    }
+    if(header->version != CONFIG_BINARY_VERSION || header->flags != 0 || header->fileSize != size || header->numConfigs > INT_MAX){
+        return 0;
+    }
+    if(header->configOffset % sizeof(uint64_t) != 0 || header->nodeOffset % sizeof(double) != 0
+       || !fitsBetween(header->configOffset, header->numConfigs, sizeof(ConfigBinaryRecord), header->nodeOffset)
+       || !fitsBetween(header->nodeOffset, header->numNodes, sizeof(ConfigBinaryNode), header->weightOffset)
+       || header->weightOffset % CONFIG_BINARY_ALIGNMENT != 0
+       || header->weightOffset > header->tagOffset || header->tagOffset > size){
+        return 0;
+    }
+    // The ConfigDesc and ConfigNode views share one allocation.
+    if(header->numNodes > (SIZE_MAX - sizeof(ConfigDesc) * (size_t)header->numConfigs) / sizeof(ConfigNode)){
+        return 0;
+    }
+    const ConfigBinaryRecord *records = (const ConfigBinaryRecord *)(data + header->configOffset);
+    uint32_t config;
+    for(config = 0; config < header->numConfigs; config++){
+        const ConfigBinaryRecord *record = &records[config];
+        uint64_t numNodes = (uint64_t)record->numInputNodes + record->numHiddenNodes;
+        if(numNodes > INT_MAX || numNodes > header->numNodes || record->firstNode > header->numNodes - numNodes
+           || record->weightOffset % sizeof(double) != 0
+           || record->weightOffset > header->tagOffset - header->weightOffset
+           || !weightsFit(header->weightOffset + record->weightOffset, record->numInputNodes, record->numHiddenNodes, header->tagOffset)
+           || record->tagOffset >= size - header->tagOffset){
+            return 0;
+        }
+        uint64_t tagOffset = header->tagOffset + record->tagOffset;
+        if(memchr(data + tagOffset, '\0', size - tagOffset) == NULL){
+            return 0;
+        }
+    }
+    return 1;
+}
+// Load a binary config file. Weights and tags are used in place from the mapped file, copied on
+// write so edits never reach the file, and one allocation holds the ConfigDesc and ConfigNode
+// views. Returns 0 if the file is missing or invalid.
+int openConfigBinary(ConfigBinary *binary, const char *path){
+    if(binary->initialised){
+        closeConfigBinary(binary);
+    }
+    size_t size = 0;
+    char *data = (char *)mapFile(path, &size);
+    if(!data || !validateConfigBinary(data, size)){
+        if(data){
+            unmapFile(data, size);
+        }
+        return 0;
+    }
+    const ConfigBinaryHeader *header = (const ConfigBinaryHeader *)data;
+    const ConfigBinaryRecord *records = (const ConfigBinaryRecord *)(data + header->configOffset);
+    const ConfigBinaryNode *binaryNodes = (const ConfigBinaryNode *)(data + header->nodeOffset);
+    ConfigDesc *configs = (ConfigDesc *)malloc(sizeof(ConfigDesc) * (size_t)header->numConfigs + sizeof(ConfigNode) * (size_t)header->numNodes);
+    if(!configs){
+        unmapFile(data, size);
+        return 0;
+    }
+    ConfigNode *nodes = (ConfigNode *)(configs + header->numConfigs);
+    uint32_t config;
+    int node;
+    for(config = 0; config < header->numConfigs; config++){
+        const ConfigBinaryRecord *record = &records[config];
+        ConfigDesc *configDesc = &configs[config];
+        int numInputNodes = (int)record->numInputNodes;
+        int numNodes = numInputNodes + (int)record->numHiddenNodes;
+        double *weights = (double *)(data + header->weightOffset + record->weightOffset);
+        configDesc->numInputNodes = numInputNodes;
+        configDesc->numHiddenNodes = (int)record->numHiddenNodes;
+        configDesc->inputNodes = nodes + record->firstNode;
+        configDesc->hiddenNodes = configDesc->inputNodes + numInputNodes;
+        configDesc->tag = data + header->tagOffset + record->tagOffset;
+        configDesc->mapped = NULL;
+        for(node = 0; node < numNodes; node++){
+            const ConfigBinaryNode *binaryNode = &binaryNodes[record->firstNode + node];
+            ConfigNode *configNode = &configDesc->inputNodes[node];
+            configNode->gain = binaryNode->gain;
+            configNode->bias = binaryNode->bias;
+            configNode->t = binaryNode->t;
+            configNode->sineCoefficient = binaryNode->sineCoefficient;
+            configNode->frequencyMultiplier = binaryNode->frequencyMultiplier;
+            // Input node weights come first, then one row of the hidden weight matrix per hidden node.
+            configNode->weights = node < numInputNodes ? weights + node : weights + numInputNodes + (size_t)(node - numInputNodes) * numNodes;
+        }
+    }
+    binary->configData.configDescriptions = configs;
+    binary->configData.numConfigs = (int)header->numConfigs;
+    binary->configData.initialised = 1;
+    binary->configData.json = NULL;
+    binary->configData.jsonOffsets = NULL;
+    binary->configData.tagIndex = NULL;
+    buildConfigTagIndex(&binary->configData);
+    binary->mapping = data;
+    binary->mappingSize = size;
+    binary->initialised = 1;
+    return 1;
+}
+// Release the views and unmap the file.
+void closeConfigBinary(ConfigBinary *binary){
+    int config;
+    // Images from mapCTRNNConfigs are the only per-config allocations.
+    for(config = 0; config < binary->configData.numConfigs; config++){
+        free(binary->configData.configDescriptions[config].mapped);
+    }
+    free(binary->configData.configDescriptions);
+    free(binary->configData.tagIndex);
+    unmapFile(binary->mapping, binary->mappingSize);
+    binary->configData.configDescriptions = NULL;
+    binary->configData.numConfigs = 0;
+    binary->configData.tagIndex = NULL;
+    binary->configData.tagIndexSize = 0;
+    binary->configData.initialised = 0;
+    binary->mapping = NULL;
+    binary->mappingSize = 0;
+    binary->initialised = 0;
+}
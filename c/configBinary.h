@@ -0,0 +1,37 @@
+#ifndef configBinary_h
+#define configBinary_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctrnnConfig.h"
+
+#define CONFIG_BINARY_VERSION 1
+
+// Configs loaded from a binary config file. configData holds ConfigDesc views whose
+// weights and tags point straight into the mapped file. The mapping is private, so they can be
+// edited in place without changing the file. configData must be released with closeConfigBinary
+// rather than destroyConfigData.
+typedef struct ConfigBinary {
+
+    ConfigData configData;
+    void *mapping; // The mapped file.
+    size_t mappingSize;
+    int initialised;
+
+} ConfigBinary;
+
+int writeConfigBinary(ConfigData *configData, const char *path);
+
+int openConfigBinary(ConfigBinary *binary, const char *path);
+
+void closeConfigBinary(ConfigBinary *binary);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* configBinary_h */
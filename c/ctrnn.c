@@ -2,142 +2,477 @@
 //  Created by Steffan Ianigro on 2/06/2016.
 //
 
+#include <stdint.h>
+#include <string.h>
 #include "ctrnn.h"
+#include "ctrnnInternal.h"
 
-// Initialse CTRNN.
-void initialiseCTRNN(CTRNN *ctrnn, ConfigDesc *configDesc, double timeStep){
-    // If CTRNN initialed, destroy the CTRNN.
+// Map the parameters of a config node into a node slot of the parameter set.
+static void mapNodeParams(CTRNNDefinition *parameters, int node, ConfigNode *configNode){
+    parameters->gain[node] = mapGain(configNode->gain);
+    parameters->gainBias[node] = parameters->gain[node] * mapBias(configNode->bias);
+    parameters->t[node] = mapTimeConstant(configNode->t);
+    parameters->sineCoefficient[node] = mapSineCoefficient(configNode->sineCoefficient);
+    parameters->tanhCoefficient[node] = 1 - parameters->sineCoefficient[node];
+    parameters->frequencyMultiplier[node] = mapFrequencyMultiplier(configNode->frequencyMultiplier);
+}
+// Per-node parameter vectors: gain, gainBias, t, sineCoefficient, tanhCoefficient and frequencyMultiplier.
+#define PARAMETER_VECTORS 6
+// Per-node state vectors: y, output, tempOutput, rate, stageY, stageYDot and yDotSum.
+#define STATE_VECTORS 7
+// Every vector in a block starts on its own cache line.
+#define VECTOR_ALIGNMENT 64
+
+// Bytes taken by a vector of count values, rounded up to whole cache lines.
+static size_t vectorBytes(size_t count){
+    size_t bytes = sizeof(double) * count;
+    return (bytes + VECTOR_ALIGNMENT - 1) / VECTOR_ALIGNMENT * VECTOR_ALIGNMENT;
+}
+// Take the next vector of count values from the block.
+static double *carveVector(char **cursor, size_t count){
+    double *vector = (double *)*cursor;
+    *cursor += vectorBytes(count);
+    return vector;
+}
+// First cache line boundary in memory.
+static char *alignBlock(void *memory){
+    return (char *)(((uintptr_t)memory + VECTOR_ALIGNMENT - 1) & ~(uintptr_t)(VECTOR_ALIGNMENT - 1));
+}
+// Bytes taken by the weights and per-node parameters of a network.
+static size_t parameterBytes(size_t numInputNodes, size_t numHiddenNodes){
+    size_t numNodes = numInputNodes + numHiddenNodes;
+    return vectorBytes(numHiddenNodes * numNodes) + vectorBytes(numInputNodes) + PARAMETER_VECTORS * vectorBytes(numNodes);
+}
+// Bytes taken by the inputs, the inputs frozen under and per-node state of a network.
+static size_t stateBytes(size_t numInputNodes, size_t numHiddenNodes){
+    return 2 * vectorBytes(numInputNodes) + STATE_VECTORS * vectorBytes(numInputNodes + numHiddenNodes);
+}
+// Bytes of storage a CTRNN built from configDesc needs, including slack to align the block.
+size_t ctrnnRequiredBytes(ConfigDesc *configDesc){
+    return VECTOR_ALIGNMENT - 1
+        + parameterBytes(configDesc->numInputNodes, configDesc->numHiddenNodes)
+        + stateBytes(configDesc->numInputNodes, configDesc->numHiddenNodes);
+}
+// Bytes of storage a CTRNN sharing definition needs, including slack to align the block.
+size_t ctrnnInstanceRequiredBytes(CTRNNDefinition *definition){
+    return VECTOR_ALIGNMENT - 1 + stateBytes(definition->numInputNodes, definition->numHiddenNodes);
+}
+// Carve the parameter vectors for configDesc out of the block.
+static void carveParameters(CTRNNDefinition *parameters, ConfigDesc *configDesc, char **cursor){
+    parameters->numInputNodes = configDesc->numInputNodes;
+    parameters->numHiddenNodes = configDesc->numHiddenNodes;
+    parameters->numNodes = configDesc->numInputNodes + configDesc->numHiddenNodes;
+    parameters->weights = carveVector(cursor, (size_t)parameters->numHiddenNodes * parameters->numNodes);
+    parameters->inputWeights = carveVector(cursor, parameters->numInputNodes);
+    parameters->gain = carveVector(cursor, parameters->numNodes);
+    parameters->gainBias = carveVector(cursor, parameters->numNodes);
+    parameters->t = carveVector(cursor, parameters->numNodes);
+    parameters->sineCoefficient = carveVector(cursor, parameters->numNodes);
+    parameters->tanhCoefficient = carveVector(cursor, parameters->numNodes);
+    parameters->frequencyMultiplier = carveVector(cursor, parameters->numNodes);
+}
+// Map configDesc into carved parameter vectors.
+static void mapParameters(CTRNNDefinition *parameters, ConfigDesc *configDesc){
+    int numNodes = parameters->numNodes;
+    const double *mapped = configDesc->mapped;
+    int node;
+    int w;
+    if(mapped){
+        // Copy the pre-mapped image.
+        memcpy(parameters->weights, mapped, sizeof(double) * parameters->numHiddenNodes * numNodes);
+        memcpy(parameters->inputWeights, mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_INPUT_WEIGHTS), sizeof(double) * parameters->numInputNodes);
+        memcpy(parameters->gain, mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_GAIN), sizeof(double) * numNodes);
+        memcpy(parameters->gainBias, mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_GAIN_BIAS), sizeof(double) * numNodes);
+        memcpy(parameters->t, mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_T), sizeof(double) * numNodes);
+        memcpy(parameters->sineCoefficient, mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_SINE_COEFFICIENT), sizeof(double) * numNodes);
+        memcpy(parameters->tanhCoefficient, mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_TANH_COEFFICIENT), sizeof(double) * numNodes);
+        memcpy(parameters->frequencyMultiplier, mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_FREQUENCY_MULTIPLIER), sizeof(double) * numNodes);
+    } else {
+        // Input Nodes
+        for(node = 0; node < parameters->numInputNodes; node++){
+            // Map params and the single weight of each input node.
+            mapNodeParams(parameters, node, &configDesc->inputNodes[node]);
+            parameters->inputWeights[node] = mapWeight(configDesc->inputNodes[node].weights[0]);
+        }
+        // Hidden Nodes
+        for(node = 0; node < parameters->numHiddenNodes; node++){
+            // Map params for each hidden node.
+            mapNodeParams(parameters, parameters->numInputNodes + node, &configDesc->hiddenNodes[node]);
+            // Map weights into the node's row of the weight matrix.
+            double *row = parameters->weights + (size_t)node * numNodes;
+            for(w = 0; w < numNodes; w++){
+                row[w] = mapWeight(configDesc->hiddenNodes[node].weights[w]);
+            }
+        }
+    }
+}
+// Destroy an initialised CTRNN, keeping its kernel, transfer, integrator and freeze selections.
+static void prepareCTRNN(CTRNN *ctrnn){
     if(ctrnn->initialised){
         destroyCTRNN(ctrnn);
+    } else {
+        ctrnn->kernels = getCTRNNKernels(CTRNN_KERNELS_AUTO);
+        ctrnn->transferMode = CTRNN_TRANSFER_ACCURATE;
+        ctrnn->integrator = CTRNN_INTEGRATE_EULER;
+        ctrnn->freezeThreshold = 0;
+        ctrnn->freezeSteps = 0;
+    }
+}
+// Refresh each node's rate from the timestep. Exponential Euler scales yDot by 1 - exp(-timeStep / t)
+// rather than timeStep / t, which moves y exactly as far as the leak would with the other inputs held.
+static void refreshRates(CTRNN *ctrnn){
+    int node;
+    for(node = 0; node < ctrnn->numNodes; node++){
+        if(ctrnn->integrator == CTRNN_INTEGRATE_EXPONENTIAL){
+            ctrnn->rate[node] = -expm1(-ctrnn->timeStep / ctrnn->t[node]);
+        } else {
+            ctrnn->rate[node] = ctrnn->timeStep / ctrnn->t[node];
+        }
     }
-    // Assign memory for CTRNN.
-    ctrnn->inputNodes = (LI *)malloc(sizeof(LI) * configDesc->numInputNodes);
-    ctrnn->hiddenNodes = (LI *)malloc(sizeof(LI) * configDesc->numHiddenNodes);
-    ctrnn->numInputNodes = configDesc->numInputNodes;
-    ctrnn->numHiddenNodes = configDesc->numHiddenNodes;
+}
+// Point the CTRNN at its parameters, carve its state from the cursor of memory and set the start state.
+static void layoutCTRNN(CTRNN *ctrnn, CTRNNDefinition *parameters, double timeStep, char *cursor, void *memory){
+    ctrnn->sineTransfer = getCTRNNSineTransfer(ctrnn->kernels, ctrnn->transferMode);
+    ctrnn->numInputNodes = parameters->numInputNodes;
+    ctrnn->numHiddenNodes = parameters->numHiddenNodes;
+    ctrnn->numNodes = parameters->numNodes;
+    ctrnn->timeStep = timeStep;
     // Num output nodes is defined in code and cannot exceed hidden nodes.
+    int numNodes = ctrnn->numNodes;
+    ctrnn->weights = parameters->weights;
+    ctrnn->inputWeights = parameters->inputWeights;
+    ctrnn->gain = parameters->gain;
+    ctrnn->gainBias = parameters->gainBias;
+    ctrnn->t = parameters->t;
+    ctrnn->sineCoefficient = parameters->sineCoefficient;
+    ctrnn->tanhCoefficient = parameters->tanhCoefficient;
+    ctrnn->frequencyMultiplier = parameters->frequencyMultiplier;
+    // Carve the state vectors out of the block.
+    ctrnn->memory = memory;
+    ctrnn->inputs = carveVector(&cursor, ctrnn->numInputNodes);
+    ctrnn->y = carveVector(&cursor, numNodes);
+    ctrnn->output = carveVector(&cursor, numNodes);
+    ctrnn->tempOutput = carveVector(&cursor, numNodes);
+    ctrnn->rate = carveVector(&cursor, numNodes);
+    ctrnn->frozenInputs = carveVector(&cursor, ctrnn->numInputNodes);
+    ctrnn->stageY = carveVector(&cursor, numNodes);
+    ctrnn->stageYDot = carveVector(&cursor, numNodes);
+    ctrnn->yDotSum = carveVector(&cursor, numNodes);
     
-    // Input Nodes
     int node;
-    int w;
+    // Rates depend on the timestep, so every CTRNN keeps its own.
+    refreshRates(ctrnn);
+    // Initiliase start state.
     for(node = 0; node < ctrnn->numInputNodes; node++){
-        // Map params for each input node.
-        ctrnn->inputNodes[node].bias = mapBias(configDesc->inputNodes[node].bias);
-        ctrnn->inputNodes[node].gain = mapGain(configDesc->inputNodes[node].gain);
-        ctrnn->inputNodes[node].t = mapTimeConstant(configDesc->inputNodes[node].t);
-        ctrnn->inputNodes[node].sineCoefficient = mapSineCoefficient(configDesc->inputNodes[node].sineCoefficient);
-        ctrnn->inputNodes[node].frequencyMultiplier = mapFrequencyMultiplier(configDesc->inputNodes[node].frequencyMultiplier);
-        // Initialise and map weights.
-        ctrnn->inputNodes[node].weights = (double *)malloc(sizeof(double));
-        ctrnn->inputNodes[node].weights[0] = mapWeight(configDesc->inputNodes[node].weights[0]);
-        // Initialise input array.
-        ctrnn->inputNodes[node].inputs = (double *)malloc(sizeof(double));
-        // Initiliase start state.
-        initialiseLI(&ctrnn->inputNodes[node], 1, timeStep);
-    }
-    // Hidden Nodes
-    for(node = 0; node < ctrnn->numHiddenNodes; node++){
-        // Map params for each input node.
-        ctrnn->hiddenNodes[node].bias = mapBias(configDesc->hiddenNodes[node].bias);
-        ctrnn->hiddenNodes[node].gain = mapGain(configDesc->hiddenNodes[node].gain);
-        ctrnn->hiddenNodes[node].t = mapTimeConstant(configDesc->hiddenNodes[node].t);
-        ctrnn->hiddenNodes[node].sineCoefficient = mapSineCoefficient(configDesc->hiddenNodes[node].sineCoefficient);
-        ctrnn->hiddenNodes[node].frequencyMultiplier = mapFrequencyMultiplier(configDesc->hiddenNodes[node].frequencyMultiplier);
-        // Initialise and map weights.
-        int numInputs = ctrnn->numInputNodes + ctrnn->numHiddenNodes;
-        ctrnn->hiddenNodes[node].weights = (double *)malloc(sizeof(double) * numInputs);
-        for(w = 0; w < numInputs; w++){
-            ctrnn->hiddenNodes[node].weights[w] = mapWeight(configDesc->hiddenNodes[node].weights[w]);
-        }
-        // Initialise input array.
-        ctrnn->hiddenNodes[node].inputs = (double *)malloc(sizeof(double) * numInputs);
-        // Initiliase start state.
-        initialiseLI(&ctrnn->hiddenNodes[node], numInputs, timeStep);
+        ctrnn->inputs[node] = 0.0;
+    }
+    for(node = 0; node < numNodes; node++){
+        ctrnn->y[node] = 0.0;
+        ctrnn->output[node] = 1.0;
+        ctrnn->tempOutput[node] = 0.0;
     }
+    thawCTRNN(ctrnn);
     ctrnn->initialised = 1;
 }
+// Lay out a CTRNN that holds its own parameters in memory, which must hold ctrnnRequiredBytes(configDesc) bytes.
+static void layoutOwnedCTRNN(CTRNN *ctrnn, ConfigDesc *configDesc, double timeStep, void *memory){
+    CTRNNDefinition parameters;
+    char *cursor = alignBlock(memory);
+    carveParameters(&parameters, configDesc, &cursor);
+    mapParameters(&parameters, configDesc);
+    layoutCTRNN(ctrnn, &parameters, timeStep, cursor, memory);
+    ctrnn->definition = NULL;
+}
+// Initialse CTRNN. All of its storage comes from a single allocation.
+void initialiseCTRNN(CTRNN *ctrnn, ConfigDesc *configDesc, double timeStep){
+    prepareCTRNN(ctrnn);
+    layoutOwnedCTRNN(ctrnn, configDesc, timeStep, malloc(ctrnnRequiredBytes(configDesc)));
+    ctrnn->ownsMemory = 1;
+}
+// Initialse CTRNN inside a caller-provided block of at least ctrnnRequiredBytes(configDesc) bytes.
+// No memory is allocated, and none is freed when the CTRNN was last initialised in place, so presets
+// can be swapped on the audio thread. A CTRNN built by initialiseCTRNN or as an instance is destroyed
+// first, which frees its memory, so destroy such a CTRNN off the audio thread before swapping into it.
+// The block must outlive the CTRNN.
+void initialiseCTRNNInPlace(CTRNN *ctrnn, ConfigDesc *configDesc, double timeStep, void *memory){
+    prepareCTRNN(ctrnn);
+    layoutOwnedCTRNN(ctrnn, configDesc, timeStep, memory);
+    ctrnn->ownsMemory = 0;
+}
+// Build an immutable definition holding the mapped weights and parameters of configDesc, with one reference.
+// The definition and its vectors come from a single allocation.
+CTRNNDefinition *createCTRNNDefinition(ConfigDesc *configDesc){
+    CTRNNDefinition *definition = (CTRNNDefinition *)malloc(sizeof(CTRNNDefinition) + VECTOR_ALIGNMENT - 1 + parameterBytes(configDesc->numInputNodes, configDesc->numHiddenNodes));
+    char *cursor = alignBlock(definition + 1);
+    carveParameters(definition, configDesc, &cursor);
+    mapParameters(definition, configDesc);
+    definition->refCount = 1;
+    return definition;
+}
+// Take another reference to a definition.
+CTRNNDefinition *retainCTRNNDefinition(CTRNNDefinition *definition){
+    __atomic_add_fetch(&definition->refCount, 1, __ATOMIC_RELAXED);
+    return definition;
+}
+// Drop a reference to a definition, freeing it with the last one.
+void releaseCTRNNDefinition(CTRNNDefinition *definition){
+    if(__atomic_sub_fetch(&definition->refCount, 1, __ATOMIC_ACQ_REL) == 0){
+        free(definition);
+    }
+}
+// Initialise CTRNN as an instance of definition. The instance reads the shared weights and parameters
+// and allocates only its inputs and node state. It holds a reference to definition until destroyed.
+void initialiseCTRNNInstance(CTRNN *ctrnn, CTRNNDefinition *definition, double timeStep){
+    // Retain before the previous network is destroyed, which may drop the last reference to definition.
+    retainCTRNNDefinition(definition);
+    prepareCTRNN(ctrnn);
+    void *memory = malloc(ctrnnInstanceRequiredBytes(definition));
+    layoutCTRNN(ctrnn, definition, timeStep, alignBlock(memory), memory);
+    ctrnn->definition = definition;
+    ctrnn->ownsMemory = 1;
+}
+// Initialise CTRNN as an instance of definition inside a caller-provided block of at least
+// ctrnnInstanceRequiredBytes(definition) bytes. The block must outlive the CTRNN. A previous
+// definition's reference is dropped, which frees it if it was the last, so keep a reference to it
+// off the audio thread when swapping there.
+void initialiseCTRNNInstanceInPlace(CTRNN *ctrnn, CTRNNDefinition *definition, double timeStep, void *memory){
+    retainCTRNNDefinition(definition);
+    prepareCTRNN(ctrnn);
+    layoutCTRNN(ctrnn, definition, timeStep, alignBlock(memory), memory);
+    ctrnn->definition = definition;
+    ctrnn->ownsMemory = 0;
+}
 // Feed CTRNN inputs.
 void feedCTRNNInputs(CTRNN *ctrnn, double inputs[]){
     int iNode;
-    // Each input node has one input thus 0 accessor.
     for(iNode = 0; iNode < ctrnn->numInputNodes; iNode++){
-        ctrnn->inputNodes[iNode].inputs[0] = inputs[iNode];
+        ctrnn->inputs[iNode] = inputs[iNode];
     }
 }
-// Update CTRNN state.
-void updateCTRNN(CTRNN *ctrnn){
+// yDot of every node at node states y whose outputs are output. yDot / t is dy/dt.
+void evaluateCTRNNYDot(CTRNN *ctrnn, const double *y, const double *output, double *yDot){
+    int numInputNodes = ctrnn->numInputNodes;
     int node;
-    int input;
-    for(node = 0; node < ctrnn->numInputNodes; node++){
-        calculateOutput(&ctrnn->inputNodes[node]);
+    for(node = 0; node < numInputNodes; node++){
+        yDot[node] = -y[node] + ctrnn->inputs[node] * ctrnn->inputWeights[node];
     }
-    for(node = 0; node < ctrnn->numHiddenNodes; node++){
-        for(input = 0; input < ctrnn->numInputNodes; input++){
-            ctrnn->hiddenNodes[node].inputs[input] = ctrnn->inputNodes[input].output;
-        }
-        for(input = 0; input < ctrnn->numHiddenNodes; input++){
-            ctrnn->hiddenNodes[node].inputs[input + ctrnn->numInputNodes] = ctrnn->hiddenNodes[input].output;
-        }
-        calculateOutput(&ctrnn->hiddenNodes[node]);
+    for(node = numInputNodes; node < ctrnn->numNodes; node++){
+        yDot[node] = -y[node];
     }
-    for(node = 0; node < ctrnn->numInputNodes; node++){
-        updateNode(&ctrnn->inputNodes[node]);
+    ctrnn->kernels->matVec(ctrnn->weights, output, yDot + numInputNodes, ctrnn->numHiddenNodes, ctrnn->numNodes);
+}
+// Outputs of every node at node states y.
+void evaluateCTRNNOutput(CTRNN *ctrnn, const double *y, double *output){
+    int node;
+    for(node = 0; node < ctrnn->numNodes; node++){
+        output[node] = ctrnn->gain[node] * y[node] - ctrnn->gainBias[node];
+    }
+    ctrnn->sineTransfer(output, ctrnn->tanhCoefficient, ctrnn->sineCoefficient, ctrnn->frequencyMultiplier, output, ctrnn->numNodes);
+}
+// Step y into stageY, fraction of a step along the stage's yDot, and evaluate the outputs there.
+// The outputs go to tempOutput, which is free until the end of the step.
+static void advanceStage(CTRNN *ctrnn, double fraction){
+    int node;
+    for(node = 0; node < ctrnn->numNodes; node++){
+        ctrnn->stageY[node] = ctrnn->y[node] + fraction * ctrnn->stageYDot[node] * ctrnn->rate[node];
+    }
+    evaluateCTRNNOutput(ctrnn, ctrnn->stageY, ctrnn->tempOutput);
+}
+// Add weight times the stage's yDot to the running sum.
+static void accumulateStage(CTRNN *ctrnn, double weight){
+    int node;
+    for(node = 0; node < ctrnn->numNodes; node++){
+        ctrnn->yDotSum[node] += weight * ctrnn->stageYDot[node];
+    }
+}
+// Heun and RK4 steps, called by stepCTRNN. The first stage reads the outputs of the previous step,
+// the others evaluate the network again at their intermediate states.
+void stepCTRNNStages(CTRNN *ctrnn){
+    int numNodes = ctrnn->numNodes;
+    int node;
+    evaluateCTRNNYDot(ctrnn, ctrnn->y, ctrnn->output, ctrnn->stageYDot);
+    if(ctrnn->freezeThreshold > 0){
+        settleCTRNN(ctrnn, ctrnn->stageYDot);
+    }
+    memcpy(ctrnn->yDotSum, ctrnn->stageYDot, sizeof(double) * numNodes);
+    double scale;
+    if(ctrnn->integrator == CTRNN_INTEGRATE_RK4){
+        advanceStage(ctrnn, 0.5);
+        evaluateCTRNNYDot(ctrnn, ctrnn->stageY, ctrnn->tempOutput, ctrnn->stageYDot);
+        accumulateStage(ctrnn, 2);
+        advanceStage(ctrnn, 0.5);
+        evaluateCTRNNYDot(ctrnn, ctrnn->stageY, ctrnn->tempOutput, ctrnn->stageYDot);
+        accumulateStage(ctrnn, 2);
+        advanceStage(ctrnn, 1);
+        evaluateCTRNNYDot(ctrnn, ctrnn->stageY, ctrnn->tempOutput, ctrnn->stageYDot);
+        accumulateStage(ctrnn, 1);
+        scale = 1.0 / 6;
+    } else {
+        advanceStage(ctrnn, 1);
+        evaluateCTRNNYDot(ctrnn, ctrnn->stageY, ctrnn->tempOutput, ctrnn->stageYDot);
+        accumulateStage(ctrnn, 1);
+        scale = 0.5;
+    }
+    for(node = 0; node < numNodes; node++){
+        ctrnn->y[node] += scale * ctrnn->yDotSum[node] * ctrnn->rate[node];
     }
-    for(node = 0; node < ctrnn->numHiddenNodes; node++){
-        updateNode(&ctrnn->hiddenNodes[node]);
+    evaluateCTRNNOutput(ctrnn, ctrnn->y, ctrnn->tempOutput);
+    double *output = ctrnn->tempOutput;
+    ctrnn->tempOutput = ctrnn->output;
+    ctrnn->output = output;
+}
+// Update CTRNN state. Out-of-line wrapper of stepCTRNN.
+void updateCTRNN(CTRNN *ctrnn){
+    stepCTRNN(ctrnn);
+}
+// Render numSteps steps in one call. Step n reads its inputs from inputs + n * inputStride
+// (an inputStride of 0 holds them, NULL inputs keep the last fed values) and writes
+// numOutputNodes outputs either interleaved per step or as one plane per output node.
+void renderCTRNNBlock(CTRNN *ctrnn, const double *inputs, int inputStride, double *outputs, int numOutputNodes, CTRNNOutputLayout layout, int numSteps){
+    int numInputNodes = ctrnn->numInputNodes;
+    int step;
+    int i;
+    for(step = 0; step < numSteps; step++){
+        if(inputs){
+            const double *frame = inputs + (size_t)step * inputStride;
+            for(i = 0; i < numInputNodes; i++){
+                ctrnn->inputs[i] = frame[i];
+            }
+        }
+        stepCTRNN(ctrnn);
+        // Output buffers swap every step, so read them after stepping.
+        const double *hiddenOutput = ctrnn->output + numInputNodes;
+        if(layout == CTRNN_OUTPUT_PLANAR){
+            for(i = 0; i < numOutputNodes; i++){
+                outputs[(size_t)i * numSteps + step] = hiddenOutput[i];
+            }
+        } else {
+            double *frame = outputs + (size_t)step * numOutputNodes;
+            for(i = 0; i < numOutputNodes; i++){
+                frame[i] = hiddenOutput[i];
+            }
+        }
     }
 }
 // Get CTRNN outputs.
 void getCTRNNOutput(CTRNN *ctrnn, double * outputs, int numOutputNodes){
+    const double *hiddenOutput = ctrnn->output + ctrnn->numInputNodes;
     int i;
     for (i = 0; i < numOutputNodes; i++) {
-        outputs[i] = getActivation(&ctrnn->hiddenNodes[i]);
+        outputs[i] = hiddenOutput[i];
     }
 }
 // Reset CTRNN nodes.
 void resetCTRNN(CTRNN *ctrnn){
     int node;
-    for(node = 0; node < ctrnn->numInputNodes; node++){
-        resetNode(&ctrnn->inputNodes[node]);
-    }
-    for(node = 0; node < ctrnn->numHiddenNodes; node++){
-        resetNode(&ctrnn->hiddenNodes[node]);
+    for(node = 0; node < ctrnn->numNodes; node++){
+        ctrnn->y[node] = 0;
+        ctrnn->output[node] = 0;
+        ctrnn->tempOutput[node] = 0;
     }
+    thawCTRNN(ctrnn);
 }
 // Change CTRNN timestep.
 void changeCTRNNTimestep(CTRNN *ctrnn, double timeStep){
+    ctrnn->timeStep = timeStep;
+    refreshRates(ctrnn);
+    thawCTRNN(ctrnn);
+}
+// Select the instruction set used to step the CTRNN. CTRNN_KERNELS_SCALAR gives the same results on every CPU.
+void selectCTRNNKernels(CTRNN *ctrnn, CTRNNKernelLevel level){
+    ctrnn->kernels = getCTRNNKernels(level);
+    ctrnn->sineTransfer = getCTRNNSineTransfer(ctrnn->kernels, ctrnn->transferMode);
+    thawCTRNN(ctrnn);
+}
+// Select the accuracy of the transfer function. Call off the audio thread, CTRNN_TRANSFER_TABLE builds its tables on first use.
+void selectCTRNNTransferMode(CTRNN *ctrnn, CTRNNTransferMode mode){
+    ctrnn->transferMode = mode;
+    ctrnn->sineTransfer = getCTRNNSineTransfer(ctrnn->kernels, mode);
+    thawCTRNN(ctrnn);
+}
+// Select how the CTRNN is integrated. Exponential Euler costs the same as forward Euler and stays
+// accurate at larger timesteps, Heun and RK4 cost two and four network evaluations per step.
+void selectCTRNNIntegrator(CTRNN *ctrnn, CTRNNIntegrator integrator){
+    ctrnn->integrator = integrator;
+    refreshRates(ctrnn);
+    thawCTRNN(ctrnn);
+}
+// Freeze the CTRNN once every node's |dy/dt| has stayed below threshold for steps steps in a row.
+// A frozen network skips its steps and holds its outputs until its inputs change. A threshold of 0
+// turns freezing off.
+void setCTRNNFreeze(CTRNN *ctrnn, double threshold, int steps){
+    ctrnn->freezeThreshold = threshold;
+    ctrnn->freezeSteps = steps < 1 ? 1 : steps;
+    thawCTRNN(ctrnn);
+}
+// Go back to integrating. Called by every function here that changes the network, call it after
+// writing to y or the parameters directly.
+void thawCTRNN(CTRNN *ctrnn){
+    ctrnn->settledSteps = 0;
+    ctrnn->frozen = 0;
+}
+// Build the engine-ready image of a config, so that initialising CTRNNs from it copies
+// the parameters in rather than mapping each one again.
+void mapCTRNNConfig(ConfigDesc *configDesc){
+    int numInputNodes = configDesc->numInputNodes;
+    int numNodes = numInputNodes + configDesc->numHiddenNodes;
     int node;
-    for(node = 0; node < ctrnn->numInputNodes; node++){
-        updateTimestep(&ctrnn->inputNodes[node], timeStep);
+    int w;
+    if(configDesc->mapped){
+        free(configDesc->mapped);
     }
-    for(node = 0; node < ctrnn->numHiddenNodes; node++){
-        updateTimestep(&ctrnn->hiddenNodes[node], timeStep);
+    double *mapped = (double *)malloc(sizeof(double) * getConfigMappedOffset(configDesc, CONFIG_MAPPED_VECTORS));
+    double *inputWeights = mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_INPUT_WEIGHTS);
+    double *gain = mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_GAIN);
+    double *gainBias = mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_GAIN_BIAS);
+    double *t = mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_T);
+    double *sineCoefficient = mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_SINE_COEFFICIENT);
+    double *tanhCoefficient = mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_TANH_COEFFICIENT);
+    double *frequencyMultiplier = mapped + getConfigMappedOffset(configDesc, CONFIG_MAPPED_FREQUENCY_MULTIPLIER);
+    for(node = 0; node < numNodes; node++){
+        ConfigNode *configNode = node < numInputNodes ? &configDesc->inputNodes[node] : &configDesc->hiddenNodes[node - numInputNodes];
+        gain[node] = mapGain(configNode->gain);
+        gainBias[node] = gain[node] * mapBias(configNode->bias);
+        t[node] = mapTimeConstant(configNode->t);
+        sineCoefficient[node] = mapSineCoefficient(configNode->sineCoefficient);
+        tanhCoefficient[node] = 1 - sineCoefficient[node];
+        frequencyMultiplier[node] = mapFrequencyMultiplier(configNode->frequencyMultiplier);
     }
-}
-// Free memory assigned for CTRNN.
-void destroyCTRNN(CTRNN *ctrnn){
-    int node;
-    for(node = 0; node < ctrnn->numInputNodes; node++){
-        if(ctrnn->inputNodes[node].weights){
-            free(ctrnn->inputNodes[node].weights);
-        }
-        if(ctrnn->inputNodes[node].inputs){
-            free(ctrnn->inputNodes[node].inputs);
-        }
+    for(node = 0; node < numInputNodes; node++){
+        inputWeights[node] = mapWeight(configDesc->inputNodes[node].weights[0]);
     }
-    for(node = 0; node < ctrnn->numHiddenNodes; node++){
-        if(ctrnn->hiddenNodes[node].weights){
-            free(ctrnn->hiddenNodes[node].weights);
+    for(node = 0; node < configDesc->numHiddenNodes; node++){
+        for(w = 0; w < numNodes; w++){
+            mapped[(size_t)node * numNodes + w] = mapWeight(configDesc->hiddenNodes[node].weights[w]);
         }
-        if(ctrnn->hiddenNodes[node].inputs){
-            free(ctrnn->hiddenNodes[node].inputs);
+    }
+    configDesc->mapped = mapped;
+}
+// Drop the engine-ready image of a config, so that CTRNNs map its nodes again. Call after editing
+// a mapped config's nodes, or map it again.
+void unmapCTRNNConfig(ConfigDesc *configDesc){
+    free(configDesc->mapped);
+    configDesc->mapped = NULL;
+}
+// Build the engine-ready image of every config. Lazily rendered configs that are not built yet are skipped.
+void mapCTRNNConfigs(ConfigData *configData){
+    int config;
+    for(config = 0; config < configData->numConfigs; config++){
+        if(configData->jsonOffsets == NULL || configData->jsonOffsets[config] == CONFIG_BUILT){
+            mapCTRNNConfig(&configData->configDescriptions[config]);
         }
     }
-    if(ctrnn->inputNodes){
-        free(ctrnn->inputNodes);
+}
+// Free memory assigned for CTRNN and drop its definition reference. Blocks passed to an in-place initialiser stay with the caller.
+void destroyCTRNN(CTRNN *ctrnn){
+    if(ctrnn->ownsMemory){
+        free(ctrnn->memory);
     }
-    if(ctrnn->hiddenNodes){
-        free(ctrnn->hiddenNodes);
+    if(ctrnn->definition){
+        releaseCTRNNDefinition(ctrnn->definition);
     }
+    ctrnn->definition = NULL;
+    ctrnn->memory = NULL;
+    ctrnn->ownsMemory = 0;
     ctrnn->initialised = 0;
 }
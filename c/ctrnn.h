@@ -11,16 +11,81 @@ extern "C" {
     
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include "mapParams.h"
-#include "leakyIntegrator.h"
 #include "ctrnnConfig.h"
+#include "ctrnnKernels.h"
 
+// Output buffer layouts of renderCTRNNBlock.
+typedef enum CTRNNOutputLayout {
+    CTRNN_OUTPUT_INTERLEAVED = 0, // outputs[step * numOutputNodes + node]
+    CTRNN_OUTPUT_PLANAR // outputs[node * numSteps + step]
+} CTRNNOutputLayout;
+
+// How stepCTRNN integrates the node equations over a time step.
+typedef enum CTRNNIntegrator {
+    CTRNN_INTEGRATE_EULER = 0, // Forward Euler. One evaluation per step.
+    CTRNN_INTEGRATE_EXPONENTIAL, // Exponential Euler, which solves the leak term exactly. One evaluation per step.
+    CTRNN_INTEGRATE_HEUN, // Second order. Two evaluations per step.
+    CTRNN_INTEGRATE_RK4 // Classic fourth-order Runge-Kutta. Four evaluations per step.
+} CTRNNIntegrator;
+
+// Immutable weights and per-node parameters of a network, shared by every CTRNN
+// initialised as an instance of it. Vectors follow the CTRNN layout below.
+typedef struct CTRNNDefinition {
+
+    double *weights;
+    double *inputWeights;
+    double *gain;
+    double *gainBias;
+    double *t;
+    double *sineCoefficient;
+    double *tanhCoefficient;
+    double *frequencyMultiplier;
+    int numInputNodes;
+    int numHiddenNodes;
+    int numNodes;
+    int refCount; // Updated atomically, so instances can be destroyed on any thread.
+
+} CTRNNDefinition;
+
+// Node state and parameters are stored as structure-of-arrays. Every per-node
+// vector holds the input nodes at [0, numInputNodes) followed by the hidden
+// nodes at [numInputNodes, numNodes).
 typedef struct CTRNN {
 
-    LI *hiddenNodes;
-    LI *inputNodes;
+    double *weights; // Hidden node weights, row-major (numHiddenNodes x numNodes). Read-only in instances.
+    double *inputWeights; // Single weight of each input node.
+    double *inputs; // External inputs fed to the input nodes.
+    double *y;
+    double *output; // Outputs of the previous step, shared by all hidden nodes.
+    double *tempOutput; // Next outputs. Swapped with output after each step.
+    double *gain;
+    double *gainBias; // gain * bias, so the activation is gain * y - gainBias.
+    double *t;
+    double *rate; // timeStep / t, or 1 - exp(-timeStep / t) for exponential Euler. Refreshed when the timestep changes.
+    double *sineCoefficient;
+    double *tanhCoefficient; // 1 - sineCoefficient.
+    double *frequencyMultiplier;
+    double *frozenInputs; // Inputs the network froze under.
+    double *stageY; // Node states at an intermediate stage of Heun and RK4.
+    double *stageYDot; // yDot at the current stage of Heun and RK4.
+    double *yDotSum; // Weighted sum of the stages' yDot.
+    double timeStep;
+    CTRNNIntegrator integrator;
+    double freezeThreshold; // |dy/dt| below which a node counts as settled. 0 turns freezing off.
+    int freezeSteps; // Steps in a row every node must be settled for before the network freezes.
+    int settledSteps; // Steps in a row on which every node was settled.
+    int frozen; // Set while the network rests on a fixed point and steps are skipped.
+    const CTRNNKernels *kernels;
+    CTRNNTransferMode transferMode;
+    CTRNNSineTransfer sineTransfer; // Transfer stage resolved from kernels and transferMode.
     int numInputNodes;
     int numHiddenNodes;
+    int numNodes;
+    void *memory; // Single block holding every vector above, or only the state vectors of an instance.
+    int ownsMemory; // Set when the block was allocated by initialiseCTRNN or initialiseCTRNNInstance.
+    CTRNNDefinition *definition; // Definition an instance reads its weights and parameters from, otherwise NULL.
     int initialised;
     
 } CTRNN;
@@ -33,12 +98,101 @@ void changeCTRNNTimestep(CTRNN *ctrnn, double timeStep);
 
 void initialiseCTRNN(CTRNN *ctrnn, ConfigDesc *configDesc, double timeStep);
 
+size_t ctrnnRequiredBytes(ConfigDesc *configDesc);
+
+void initialiseCTRNNInPlace(CTRNN *ctrnn, ConfigDesc *configDesc, double timeStep, void *memory);
+
+CTRNNDefinition *createCTRNNDefinition(ConfigDesc *configDesc);
+
+CTRNNDefinition *retainCTRNNDefinition(CTRNNDefinition *definition);
+
+void releaseCTRNNDefinition(CTRNNDefinition *definition);
+
+size_t ctrnnInstanceRequiredBytes(CTRNNDefinition *definition);
+
+void initialiseCTRNNInstance(CTRNN *ctrnn, CTRNNDefinition *definition, double timeStep);
+
+void initialiseCTRNNInstanceInPlace(CTRNN *ctrnn, CTRNNDefinition *definition, double timeStep, void *memory);
+
 void feedCTRNNInputs(CTRNN *ctrnn, double inputs[]);
 
 void getCTRNNOutput(CTRNN *ctrnn, double * outputs, int numOutputNodes);
 
 void updateCTRNN(CTRNN *ctrnn);
 
+void renderCTRNNBlock(CTRNN *ctrnn, const double *inputs, int inputStride, double *outputs, int numOutputNodes, CTRNNOutputLayout layout, int numSteps);
+
+void selectCTRNNKernels(CTRNN *ctrnn, CTRNNKernelLevel level);
+
+void selectCTRNNTransferMode(CTRNN *ctrnn, CTRNNTransferMode mode);
+
+void selectCTRNNIntegrator(CTRNN *ctrnn, CTRNNIntegrator integrator);
+
+void setCTRNNFreeze(CTRNN *ctrnn, double threshold, int steps);
+
+void thawCTRNN(CTRNN *ctrnn);
+
+void mapCTRNNConfig(ConfigDesc *configDesc);
+
+void unmapCTRNNConfig(ConfigDesc *configDesc);
+
+void mapCTRNNConfigs(ConfigData *configData);
+
+// Helpers of the inline step below. Not part of the public API.
+#include "ctrnnInternal.h"
+
+// Advance every node by one time step. Defined here so that callers stepping in their own
+// sample loops can inline it. The mat-vec and transfer stages stay behind the kernel table
+// selected at runtime. updateCTRNN is the out-of-line equivalent.
+static inline void stepCTRNN(CTRNN *ctrnn){
+    int numInputNodes = ctrnn->numInputNodes;
+    int numNodes = ctrnn->numNodes;
+    double *y = ctrnn->y;
+    double *yDot = ctrnn->tempOutput;
+    int node;
+    // A frozen network rests on a fixed point, so its outputs hold until its inputs move.
+    if(ctrnn->frozen){
+        for(node = 0; node < numInputNodes && ctrnn->inputs[node] == ctrnn->frozenInputs[node]; node++){
+        }
+        if(node == numInputNodes){
+            return;
+        }
+        ctrnn->frozen = 0;
+    }
+    // Heun and RK4 evaluate the network several times per step, out of line.
+    if(ctrnn->integrator >= CTRNN_INTEGRATE_HEUN){
+        stepCTRNNStages(ctrnn);
+        return;
+    }
+    // Input nodes have a single weighted external input.
+    for(node = 0; node < numInputNodes; node++){
+        yDot[node] = -y[node] + ctrnn->inputs[node] * ctrnn->inputWeights[node];
+    }
+    // Hidden nodes read the previous outputs of all nodes straight from the
+    // shared output vector, making their weighted sums a plain mat-vec.
+    for(node = numInputNodes; node < numNodes; node++){
+        yDot[node] = -y[node];
+    }
+    ctrnn->kernels->matVec(ctrnn->weights, ctrnn->output, yDot + numInputNodes, ctrnn->numHiddenNodes, numNodes);
+    const double *rate = ctrnn->rate;
+    const double *gain = ctrnn->gain;
+    const double *gainBias = ctrnn->gainBias;
+    // Freeze after freezeSteps steps in a row on which no node moved faster than freezeThreshold.
+    if(ctrnn->freezeThreshold > 0){
+        settleCTRNN(ctrnn, yDot);
+    }
+    // Integrate every node. Each node's activation overwrites its yDot slot. Exponential Euler
+    // differs from forward Euler only in its rates.
+    for(node = 0; node < numNodes; node++){
+        y[node] += yDot[node] * rate[node];
+        yDot[node] = gain[node] * y[node] - gainBias[node];
+    }
+    ctrnn->sineTransfer(yDot, ctrnn->tanhCoefficient, ctrnn->sineCoefficient, ctrnn->frequencyMultiplier, yDot, numNodes);
+    // New outputs become current by swapping buffers rather than copying.
+    ctrnn->tempOutput = ctrnn->output;
+    ctrnn->output = yDot;
+}
+
 
 #ifdef __cplusplus 
 }
@@ -0,0 +1,217 @@
+#include <math.h>
+#include <string.h>
+#include "ctrnnAdaptive.h"
+#include "ctrnnInternal.h"
+
+// Steps this short, in time units, are taken whatever their error, so a network too stiff for the
+// tolerance slows down rather than stalls.
+#define ADAPTIVE_MIN_STEP 1e-6
+// Most a step can grow or shrink the next one by, and the margin kept below the length the error
+// estimate asks for.
+#define ADAPTIVE_MAX_GROWTH 5.0
+#define ADAPTIVE_MAX_SHRINK 0.2
+#define ADAPTIVE_SAFETY 0.9
+
+// dy/dt of every node at node states y whose outputs are output.
+static void evaluateSlope(CTRNNAdaptive *adaptive, const double *y, const double *output, double *slope){
+    CTRNN *ctrnn = adaptive->ctrnn;
+    int node;
+    evaluateCTRNNYDot(ctrnn, y, output, slope);
+    for(node = 0; node < ctrnn->numNodes; node++){
+        slope[node] /= ctrnn->t[node];
+    }
+    adaptive->evaluations++;
+}
+// Take one step from start, the longest the error estimate allows up to nextStep. The end state and
+// its outputs go to the network.
+static void takeStep(CTRNNAdaptive *adaptive){
+    CTRNN *ctrnn = adaptive->ctrnn;
+    int numNodes = ctrnn->numNodes;
+    const double *start = adaptive->start;
+    const double *k1 = adaptive->startSlope;
+    double *k2 = adaptive->slopes[0];
+    double *k3 = adaptive->slopes[1];
+    double *k4 = adaptive->endSlope;
+    double *stage = adaptive->stage;
+    int node;
+    for(;;){
+        double h = adaptive->nextStep < adaptive->maxStep ? adaptive->nextStep : adaptive->maxStep;
+        for(node = 0; node < numNodes; node++){
+            stage[node] = start[node] + 0.5 * h * k1[node];
+        }
+        evaluateCTRNNOutput(ctrnn, stage, adaptive->stageOutput);
+        evaluateSlope(adaptive, stage, adaptive->stageOutput, k2);
+        for(node = 0; node < numNodes; node++){
+            stage[node] = start[node] + 0.75 * h * k2[node];
+        }
+        evaluateCTRNNOutput(ctrnn, stage, adaptive->stageOutput);
+        evaluateSlope(adaptive, stage, adaptive->stageOutput, k3);
+        for(node = 0; node < numNodes; node++){
+            ctrnn->y[node] = start[node] + h * (2.0 / 9 * k1[node] + 1.0 / 3 * k2[node] + 4.0 / 9 * k3[node]);
+        }
+        evaluateCTRNNOutput(ctrnn, ctrnn->y, ctrnn->output);
+        evaluateSlope(adaptive, ctrnn->y, ctrnn->output, k4);
+        // The embedded second-order solution differs from the third-order one by the error estimate.
+        double error = 0;
+        for(node = 0; node < numNodes; node++){
+            double difference = fabs(h * (-5.0 / 72 * k1[node] + 1.0 / 12 * k2[node] + 1.0 / 9 * k3[node] - 1.0 / 8 * k4[node]));
+            if(difference > error){
+                error = difference;
+            }
+        }
+        double ratio = error / adaptive->tolerance;
+        double factor = ratio > 0 ? ADAPTIVE_SAFETY * pow(ratio, -1.0 / 3) : ADAPTIVE_MAX_GROWTH;
+        factor = factor > ADAPTIVE_MAX_GROWTH ? ADAPTIVE_MAX_GROWTH : factor < ADAPTIVE_MAX_SHRINK ? ADAPTIVE_MAX_SHRINK : factor;
+        if(ratio <= 1 || h <= ADAPTIVE_MIN_STEP){
+            adaptive->step = h;
+            adaptive->nextStep = h * factor;
+            return;
+        }
+        adaptive->nextStep = h * factor > ADAPTIVE_MIN_STEP ? h * factor : ADAPTIVE_MIN_STEP;
+    }
+}
+// Start stepping from the network's current state and inputs.
+static void beginSteps(CTRNNAdaptive *adaptive){
+    CTRNN *ctrnn = adaptive->ctrnn;
+    memcpy(adaptive->inputs, ctrnn->inputs, sizeof(double) * ctrnn->numInputNodes);
+    memcpy(adaptive->start, ctrnn->y, sizeof(double) * ctrnn->numNodes);
+    evaluateSlope(adaptive, ctrnn->y, ctrnn->output, adaptive->startSlope);
+    adaptive->position = 0;
+    takeStep(adaptive);
+}
+// Move on to the step that starts where the current one ends.
+static void advanceStep(CTRNNAdaptive *adaptive){
+    double *slope = adaptive->startSlope;
+    adaptive->position -= adaptive->step;
+    memcpy(adaptive->start, adaptive->ctrnn->y, sizeof(double) * adaptive->ctrnn->numNodes);
+    adaptive->startSlope = adaptive->endSlope;
+    adaptive->endSlope = slope;
+    takeStep(adaptive);
+}
+// Interpolate y of count nodes from first at the current position. The cubic Hermite through both
+// ends of the step and their slopes is third order, like the step itself.
+static void interpolateStep(CTRNNAdaptive *adaptive, int first, int count, double *y){
+    const double *start = adaptive->start + first;
+    const double *startSlope = adaptive->startSlope + first;
+    const double *end = adaptive->ctrnn->y + first;
+    const double *endSlope = adaptive->endSlope + first;
+    double h = adaptive->step;
+    double theta = adaptive->position / h;
+    double rest = 1 - theta;
+    double startWeight = (1 + 2 * theta) * rest * rest;
+    double startSlopeWeight = theta * rest * rest * h;
+    double endWeight = theta * theta * (3 - 2 * theta);
+    double endSlopeWeight = -theta * theta * rest * h;
+    int i;
+    for(i = 0; i < count; i++){
+        y[i] = startWeight * start[i] + startSlopeWeight * startSlope[i] + endWeight * end[i] + endSlopeWeight * endSlope[i];
+    }
+}
+// Whether the network's inputs differ from those the current step was taken under.
+static int inputsChanged(CTRNNAdaptive *adaptive){
+    int i;
+    for(i = 0; i < adaptive->ctrnn->numInputNodes; i++){
+        if(adaptive->ctrnn->inputs[i] != adaptive->inputs[i]){
+            return 1;
+        }
+    }
+    return 0;
+}
+// Initialise adaptive integration of ctrnn for its first numOutputNodes outputs. Steps of up to
+// maxStep time units are taken while every node's estimated error stays within tolerance. Outputs
+// are produced every timeStep of the network.
+void initialiseCTRNNAdaptive(CTRNNAdaptive *adaptive, CTRNN *ctrnn, int numOutputNodes, double tolerance, double maxStep){
+    int numNodes = ctrnn->numNodes;
+    if(adaptive->initialised){
+        destroyCTRNNAdaptive(adaptive);
+    }
+    adaptive->ctrnn = ctrnn;
+    adaptive->tolerance = tolerance;
+    adaptive->maxStep = maxStep > ADAPTIVE_MIN_STEP ? maxStep : ADAPTIVE_MIN_STEP;
+    adaptive->numOutputNodes = numOutputNodes;
+    adaptive->memory = malloc(sizeof(double) * ((size_t)7 * numNodes + ctrnn->numInputNodes + numOutputNodes));
+    adaptive->start = (double *)adaptive->memory;
+    adaptive->startSlope = adaptive->start + numNodes;
+    adaptive->endSlope = adaptive->startSlope + numNodes;
+    adaptive->stage = adaptive->endSlope + numNodes;
+    adaptive->stageOutput = adaptive->stage + numNodes;
+    adaptive->slopes[0] = adaptive->stageOutput + numNodes;
+    adaptive->slopes[1] = adaptive->slopes[0] + numNodes;
+    adaptive->inputs = adaptive->slopes[1] + numNodes;
+    adaptive->playback = adaptive->inputs + ctrnn->numInputNodes;
+    adaptive->evaluations = 0;
+    resetCTRNNAdaptive(adaptive);
+    adaptive->initialised = 1;
+}
+// Start again from the network's current state. Call after changing the network itself, for example
+// with resetCTRNN or changeCTRNNTimestep.
+void resetCTRNNAdaptive(CTRNNAdaptive *adaptive){
+    adaptive->step = 0;
+    adaptive->nextStep = adaptive->ctrnn->timeStep;
+    adaptive->position = 0;
+}
+// Advance the outputs by the network's timestep, taking as many steps as that needs. Inputs fed to
+// the network with feedCTRNNInputs since the last update apply from the current output time.
+void updateCTRNNAdaptive(CTRNNAdaptive *adaptive){
+    CTRNN *ctrnn = adaptive->ctrnn;
+    int first = ctrnn->numInputNodes;
+    int i;
+    if(adaptive->step == 0){
+        beginSteps(adaptive);
+    } else if(inputsChanged(adaptive)){
+        interpolateStep(adaptive, 0, ctrnn->numNodes, adaptive->stage);
+        memcpy(ctrnn->y, adaptive->stage, sizeof(double) * ctrnn->numNodes);
+        evaluateCTRNNOutput(ctrnn, ctrnn->y, ctrnn->output);
+        beginSteps(adaptive);
+    }
+    adaptive->position += ctrnn->timeStep;
+    while(adaptive->position > adaptive->step){
+        advanceStep(adaptive);
+    }
+    // Outputs of the interpolated node states, rather than interpolated outputs, which move far
+    // faster than y at high gains and frequency multipliers.
+    interpolateStep(adaptive, first, adaptive->numOutputNodes, adaptive->playback);
+    for(i = 0; i < adaptive->numOutputNodes; i++){
+        adaptive->playback[i] = ctrnn->gain[first + i] * adaptive->playback[i] - ctrnn->gainBias[first + i];
+    }
+    ctrnn->sineTransfer(adaptive->playback, ctrnn->tanhCoefficient + first, ctrnn->sineCoefficient + first, ctrnn->frequencyMultiplier + first, adaptive->playback, adaptive->numOutputNodes);
+}
+// Get the outputs at the current output time. The network itself holds the end of the current step.
+void getCTRNNAdaptiveOutput(CTRNNAdaptive *adaptive, double * outputs, int numOutputNodes){
+    int i;
+    for(i = 0; i < numOutputNodes; i++){
+        outputs[i] = adaptive->playback[i];
+    }
+}
+// Render numSteps output steps in one call, writing the outputs adaptive was initialised with. See renderCTRNNBlock.
+void renderCTRNNAdaptiveBlock(CTRNNAdaptive *adaptive, const double *inputs, int inputStride, double *outputs, CTRNNOutputLayout layout, int numSteps){
+    CTRNN *ctrnn = adaptive->ctrnn;
+    int numOutputNodes = adaptive->numOutputNodes;
+    int step;
+    int i;
+    for(step = 0; step < numSteps; step++){
+        if(inputs){
+            const double *inputFrame = inputs + (size_t)step * inputStride;
+            for(i = 0; i < ctrnn->numInputNodes; i++){
+                ctrnn->inputs[i] = inputFrame[i];
+            }
+        }
+        updateCTRNNAdaptive(adaptive);
+        if(layout == CTRNN_OUTPUT_PLANAR){
+            for(i = 0; i < numOutputNodes; i++){
+                outputs[(size_t)i * numSteps + step] = adaptive->playback[i];
+            }
+        } else {
+            double *frame = outputs + (size_t)step * numOutputNodes;
+            for(i = 0; i < numOutputNodes; i++){
+                frame[i] = adaptive->playback[i];
+            }
+        }
+    }
+}
+// Free memory assigned for adaptive integration. The network stays with the caller.
+void destroyCTRNNAdaptive(CTRNNAdaptive *adaptive){
+    free(adaptive->memory);
+    adaptive->memory = NULL;
+    adaptive->initialised = 0;
+}
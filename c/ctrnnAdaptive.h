@@ -0,0 +1,55 @@
+#ifndef ctrnnAdaptive_h
+#define ctrnnAdaptive_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctrnn.h"
+
+// Integrates a CTRNN with adaptive steps of the Bogacki-Shampine 3(2) pair, taking the longest
+// steps whose estimated error in any node's y stays within a tolerance. Outputs still arrive every
+// timeStep of the network, interpolated from the steps either side, so slow networks take far
+// fewer steps than outputs while fast or stiff ones take as many as they need.
+typedef struct CTRNNAdaptive {
+
+    CTRNN *ctrnn; // Integrated network, owned by the caller. Holds the state at the end of the current step.
+    double tolerance; // Largest estimated error in any node's y over one step.
+    double maxStep; // Longest step in time units.
+    int numOutputNodes;
+    double step; // Length of the current step in time units, 0 before the first step.
+    double nextStep; // Length to try for the next step.
+    double position; // Time of the current output since the start of the current step.
+    long evaluations; // Network evaluations so far, rejected steps included.
+    double *start; // y at the start of the current step.
+    double *startSlope; // dy/dt at the start of the current step.
+    double *endSlope; // dy/dt at the end of the current step.
+    double *stage; // y at an intermediate stage.
+    double *stageOutput; // Outputs at an intermediate stage.
+    double *slopes[2]; // dy/dt at the two intermediate stages.
+    double *inputs; // Inputs the current step was taken under.
+    double *playback; // Hidden outputs at the current output time.
+    void *memory; // Single block holding the vectors above.
+    int initialised;
+
+} CTRNNAdaptive;
+
+void initialiseCTRNNAdaptive(CTRNNAdaptive *adaptive, CTRNN *ctrnn, int numOutputNodes, double tolerance, double maxStep);
+
+void resetCTRNNAdaptive(CTRNNAdaptive *adaptive);
+
+void updateCTRNNAdaptive(CTRNNAdaptive *adaptive);
+
+void getCTRNNAdaptiveOutput(CTRNNAdaptive *adaptive, double * outputs, int numOutputNodes);
+
+void renderCTRNNAdaptiveBlock(CTRNNAdaptive *adaptive, const double *inputs, int inputStride, double *outputs, CTRNNOutputLayout layout, int numSteps);
+
+void destroyCTRNNAdaptive(CTRNNAdaptive *adaptive);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ctrnnAdaptive_h */
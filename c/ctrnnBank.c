@@ -0,0 +1,206 @@
+#include "ctrnnBank.h"
+
+// Lanes are padded to the widest vector the kernels use.
+#define BANK_LANE_ALIGNMENT 8
+
+// Map the parameters of a config node into a node slot of one instance.
+static void mapBankNodeParams(CTRNNBank *bank, int node, int instance, ConfigNode *configNode){
+    size_t index = (size_t)node * bank->numLanes + instance;
+    bank->gain[index] = mapGain(configNode->gain);
+    bank->gainBias[index] = bank->gain[index] * mapBias(configNode->bias);
+    bank->t[index] = mapTimeConstant(configNode->t);
+    bank->rate[index] = bank->timeStep / bank->t[index];
+    bank->sineCoefficient[index] = mapSineCoefficient(configNode->sineCoefficient);
+    bank->tanhCoefficient[index] = 1 - bank->sineCoefficient[index];
+    bank->frequencyMultiplier[index] = mapFrequencyMultiplier(configNode->frequencyMultiplier);
+}
+// Scatter a config's pre-mapped image into the lanes of one instance.
+static void assignBankMappedConfig(CTRNNBank *bank, int instance, ConfigDesc *configDesc){
+    const double *weights = configDesc->mapped;
+    const double *inputWeights = weights + getConfigMappedOffset(configDesc, CONFIG_MAPPED_INPUT_WEIGHTS);
+    const double *gain = weights + getConfigMappedOffset(configDesc, CONFIG_MAPPED_GAIN);
+    const double *gainBias = weights + getConfigMappedOffset(configDesc, CONFIG_MAPPED_GAIN_BIAS);
+    const double *t = weights + getConfigMappedOffset(configDesc, CONFIG_MAPPED_T);
+    const double *sineCoefficient = weights + getConfigMappedOffset(configDesc, CONFIG_MAPPED_SINE_COEFFICIENT);
+    const double *tanhCoefficient = weights + getConfigMappedOffset(configDesc, CONFIG_MAPPED_TANH_COEFFICIENT);
+    const double *frequencyMultiplier = weights + getConfigMappedOffset(configDesc, CONFIG_MAPPED_FREQUENCY_MULTIPLIER);
+    size_t numWeights = (size_t)bank->numHiddenNodes * bank->numNodes;
+    size_t i;
+    int node;
+    for(i = 0; i < numWeights; i++){
+        bank->weights[i * bank->numLanes + instance] = weights[i];
+    }
+    for(node = 0; node < bank->numInputNodes; node++){
+        bank->inputWeights[(size_t)node * bank->numLanes + instance] = inputWeights[node];
+    }
+    for(node = 0; node < bank->numNodes; node++){
+        size_t index = (size_t)node * bank->numLanes + instance;
+        bank->gain[index] = gain[node];
+        bank->gainBias[index] = gainBias[node];
+        bank->t[index] = t[node];
+        bank->rate[index] = bank->timeStep / t[node];
+        bank->sineCoefficient[index] = sineCoefficient[node];
+        bank->tanhCoefficient[index] = tanhCoefficient[node];
+        bank->frequencyMultiplier[index] = frequencyMultiplier[node];
+    }
+}
+// Set the start state of one instance.
+static void resetBankInstance(CTRNNBank *bank, int instance, double output){
+    int node;
+    for(node = 0; node < bank->numNodes; node++){
+        size_t index = (size_t)node * bank->numLanes + instance;
+        bank->y[index] = 0.0;
+        bank->output[index] = output;
+        bank->tempOutput[index] = 0.0;
+    }
+}
+// Initialise a bank of numInstances CTRNNs. Instances stay silent until a config is assigned.
+void initialiseCTRNNBank(CTRNNBank *bank, int numInstances, int numInputNodes, int numHiddenNodes, double timeStep){
+    // If bank initialised, destroy the bank but keep its kernel and transfer selections.
+    if(bank->initialised){
+        destroyCTRNNBank(bank);
+    } else {
+        // Lanes always fill whole 8-wide vectors, so banks use AVX-512 where available.
+        bank->kernels = getCTRNNKernels(CTRNN_KERNELS_AVX512);
+        bank->transferMode = CTRNN_TRANSFER_ACCURATE;
+    }
+    bank->sineTransfer = getCTRNNSineTransfer(bank->kernels, bank->transferMode);
+    bank->numInstances = numInstances;
+    bank->numLanes = (numInstances + BANK_LANE_ALIGNMENT - 1) / BANK_LANE_ALIGNMENT * BANK_LANE_ALIGNMENT;
+    bank->numInputNodes = numInputNodes;
+    bank->numHiddenNodes = numHiddenNodes;
+    bank->numNodes = numInputNodes + numHiddenNodes;
+    bank->timeStep = timeStep;
+    size_t nodeLanes = (size_t)bank->numNodes * bank->numLanes;
+    size_t inputLanes = (size_t)numInputNodes * bank->numLanes;
+    // Assign memory for bank. Unassigned lanes have zero weights and outputs.
+    bank->weights = (double *)calloc((size_t)numHiddenNodes * nodeLanes, sizeof(double));
+    bank->inputWeights = (double *)calloc(inputLanes, sizeof(double));
+    bank->inputs = (double *)calloc(inputLanes, sizeof(double));
+    bank->y = (double *)calloc(nodeLanes, sizeof(double));
+    bank->output = (double *)calloc(nodeLanes, sizeof(double));
+    bank->tempOutput = (double *)calloc(nodeLanes, sizeof(double));
+    bank->gain = (double *)calloc(nodeLanes, sizeof(double));
+    bank->gainBias = (double *)calloc(nodeLanes, sizeof(double));
+    bank->t = (double *)malloc(sizeof(double) * nodeLanes);
+    bank->rate = (double *)malloc(sizeof(double) * nodeLanes);
+    bank->sineCoefficient = (double *)calloc(nodeLanes, sizeof(double));
+    bank->tanhCoefficient = (double *)malloc(sizeof(double) * nodeLanes);
+    bank->frequencyMultiplier = (double *)calloc(nodeLanes, sizeof(double));
+    size_t i;
+    for(i = 0; i < nodeLanes; i++){
+        bank->t[i] = 1.0;
+        bank->rate[i] = timeStep;
+        bank->tanhCoefficient[i] = 1.0;
+    }
+    bank->initialised = 1;
+}
+// Map a config into one instance and reset its state. Returns 0 if the config topology does not match the bank.
+int assignCTRNNBankConfig(CTRNNBank *bank, int instance, ConfigDesc *configDesc){
+    if(configDesc->numInputNodes != bank->numInputNodes || configDesc->numHiddenNodes != bank->numHiddenNodes){
+        return 0;
+    }
+    int numLanes = bank->numLanes;
+    int numNodes = bank->numNodes;
+    int node;
+    int w;
+    if(configDesc->mapped){
+        assignBankMappedConfig(bank, instance, configDesc);
+    } else {
+        // Input Nodes
+        for(node = 0; node < bank->numInputNodes; node++){
+            mapBankNodeParams(bank, node, instance, &configDesc->inputNodes[node]);
+            bank->inputWeights[(size_t)node * numLanes + instance] = mapWeight(configDesc->inputNodes[node].weights[0]);
+        }
+        // Hidden Nodes
+        for(node = 0; node < bank->numHiddenNodes; node++){
+            mapBankNodeParams(bank, bank->numInputNodes + node, instance, &configDesc->hiddenNodes[node]);
+            double *row = bank->weights + (size_t)node * numNodes * numLanes;
+            for(w = 0; w < numNodes; w++){
+                row[(size_t)w * numLanes + instance] = mapWeight(configDesc->hiddenNodes[node].weights[w]);
+            }
+        }
+    }
+    resetBankInstance(bank, instance, 1.0);
+    return 1;
+}
+// Feed the inputs of one instance.
+void feedCTRNNBankInputs(CTRNNBank *bank, int instance, double inputs[]){
+    int iNode;
+    for(iNode = 0; iNode < bank->numInputNodes; iNode++){
+        bank->inputs[(size_t)iNode * bank->numLanes + instance] = inputs[iNode];
+    }
+}
+// Update the state of every instance.
+void updateCTRNNBank(CTRNNBank *bank){
+    size_t inputLanes = (size_t)bank->numInputNodes * bank->numLanes;
+    size_t nodeLanes = (size_t)bank->numNodes * bank->numLanes;
+    double *yDot = bank->tempOutput;
+    size_t i;
+    for(i = 0; i < inputLanes; i++){
+        yDot[i] = -1 * bank->y[i] + bank->inputs[i] * bank->inputWeights[i];
+    }
+    for(i = inputLanes; i < nodeLanes; i++){
+        yDot[i] = -1 * bank->y[i];
+    }
+    bank->kernels->laneMatVec(bank->weights, bank->output, yDot + inputLanes, bank->numHiddenNodes, bank->numNodes, bank->numLanes);
+    // Integrate every lane of every node. Activations overwrite their yDot slot.
+    for(i = 0; i < nodeLanes; i++){
+        bank->y[i] += yDot[i] * bank->rate[i];
+        yDot[i] = bank->gain[i] * bank->y[i] - bank->gainBias[i];
+    }
+    bank->sineTransfer(yDot, bank->tanhCoefficient, bank->sineCoefficient, bank->frequencyMultiplier, yDot, (int)nodeLanes);
+    bank->tempOutput = bank->output;
+    bank->output = yDot;
+}
+// Get the outputs of one instance.
+void getCTRNNBankOutput(CTRNNBank *bank, int instance, double * outputs, int numOutputNodes){
+    const double *hiddenOutput = bank->output + (size_t)bank->numInputNodes * bank->numLanes;
+    int i;
+    for(i = 0; i < numOutputNodes; i++){
+        outputs[i] = hiddenOutput[(size_t)i * bank->numLanes + instance];
+    }
+}
+// Reset every instance.
+void resetCTRNNBank(CTRNNBank *bank){
+    int instance;
+    for(instance = 0; instance < bank->numLanes; instance++){
+        resetBankInstance(bank, instance, 0.0);
+    }
+}
+// Change bank timestep.
+void changeCTRNNBankTimestep(CTRNNBank *bank, double timeStep){
+    size_t nodeLanes = (size_t)bank->numNodes * bank->numLanes;
+    size_t i;
+    bank->timeStep = timeStep;
+    for(i = 0; i < nodeLanes; i++){
+        bank->rate[i] = timeStep / bank->t[i];
+    }
+}
+// Select the instruction set used to step the bank.
+void selectCTRNNBankKernels(CTRNNBank *bank, CTRNNKernelLevel level){
+    bank->kernels = getCTRNNKernels(level);
+    bank->sineTransfer = getCTRNNSineTransfer(bank->kernels, bank->transferMode);
+}
+// Select the accuracy of the transfer function.
+void selectCTRNNBankTransferMode(CTRNNBank *bank, CTRNNTransferMode mode){
+    bank->transferMode = mode;
+    bank->sineTransfer = getCTRNNSineTransfer(bank->kernels, mode);
+}
+// Free memory assigned for bank.
+void destroyCTRNNBank(CTRNNBank *bank){
+    free(bank->weights);
+    free(bank->inputWeights);
+    free(bank->inputs);
+    free(bank->y);
+    free(bank->output);
+    free(bank->tempOutput);
+    free(bank->gain);
+    free(bank->gainBias);
+    free(bank->t);
+    free(bank->rate);
+    free(bank->sineCoefficient);
+    free(bank->tanhCoefficient);
+    free(bank->frequencyMultiplier);
+    bank->initialised = 0;
+}
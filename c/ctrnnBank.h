@@ -0,0 +1,70 @@
+#ifndef ctrnnBank_h
+#define ctrnnBank_h
+
+#ifdef __cplusplus 
+extern "C" { 
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "mapParams.h"
+#include "ctrnnConfig.h"
+#include "ctrnnKernels.h"
+
+// Many CTRNNs with the same topology stepped together. Every per-node vector
+// is interleaved as [node][lane] with one lane per instance, so one step is
+// vectorised across instances rather than across nodes. Node order within
+// an instance matches CTRNN: input nodes first, then hidden nodes.
+typedef struct CTRNNBank {
+
+    double *weights; // Hidden node weights, [hidden node][node][lane].
+    double *inputWeights; // [input node][lane]
+    double *inputs; // [input node][lane]
+    double *y;
+    double *output;
+    double *tempOutput;
+    double *gain;
+    double *gainBias; // gain * bias, so the activation is gain * y - gainBias.
+    double *t;
+    double *rate; // timeStep / t, refreshed when the timestep changes.
+    double *sineCoefficient;
+    double *tanhCoefficient; // 1 - sineCoefficient.
+    double *frequencyMultiplier;
+    double timeStep;
+    const CTRNNKernels *kernels;
+    CTRNNTransferMode transferMode;
+    CTRNNSineTransfer sineTransfer; // Transfer stage resolved from kernels and transferMode.
+    int numInstances;
+    int numLanes; // numInstances padded to a whole number of vectors.
+    int numInputNodes;
+    int numHiddenNodes;
+    int numNodes;
+    int initialised;
+
+} CTRNNBank;
+
+void initialiseCTRNNBank(CTRNNBank *bank, int numInstances, int numInputNodes, int numHiddenNodes, double timeStep);
+
+int assignCTRNNBankConfig(CTRNNBank *bank, int instance, ConfigDesc *configDesc);
+
+void feedCTRNNBankInputs(CTRNNBank *bank, int instance, double inputs[]);
+
+void updateCTRNNBank(CTRNNBank *bank);
+
+void getCTRNNBankOutput(CTRNNBank *bank, int instance, double * outputs, int numOutputNodes);
+
+void resetCTRNNBank(CTRNNBank *bank);
+
+void changeCTRNNBankTimestep(CTRNNBank *bank, double timeStep);
+
+void selectCTRNNBankKernels(CTRNNBank *bank, CTRNNKernelLevel level);
+
+void selectCTRNNBankTransferMode(CTRNNBank *bank, CTRNNTransferMode mode);
+
+void destroyCTRNNBank(CTRNNBank *bank);
+
+#ifdef __cplusplus 
+}
+#endif
+
+#endif /* ctrnnBank_h */
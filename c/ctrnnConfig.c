@@ -2,6 +2,7 @@
 //  Created by Steffan Ianigro on 4/06/2016.
 //
 
+#include <string.h>
 #include "ctrnnConfig.h"
 
 void initConfigDesc(ConfigDesc *configDesc, int numInputNodes, int numberHiddenNodes){
@@ -10,6 +11,20 @@ void initConfigDesc(ConfigDesc *configDesc, int numInputNodes, int numberHiddenN
     configDesc->hiddenNodes = (ConfigNode *)malloc(sizeof(ConfigNode) * numberHiddenNodes);
     configDesc->numInputNodes = numInputNodes;
     configDesc->numHiddenNodes = numberHiddenNodes;
+    configDesc->tag = NULL;
+    configDesc->mapped = NULL;
+}
+
+size_t getConfigMappedOffset(ConfigDesc *configDesc, ConfigMappedVector vector){
+    size_t numNodes = configDesc->numInputNodes + configDesc->numHiddenNodes;
+    size_t weightsLength = configDesc->numHiddenNodes * numNodes;
+    if(vector == CONFIG_MAPPED_WEIGHTS){
+        return 0;
+    }
+    if(vector == CONFIG_MAPPED_INPUT_WEIGHTS){
+        return weightsLength;
+    }
+    return weightsLength + configDesc->numInputNodes + (vector - CONFIG_MAPPED_GAIN) * numNodes;
 }
 
 void initConfigData(ConfigData *configData, int numConfigs){
@@ -18,36 +33,128 @@ void initConfigData(ConfigData *configData, int numConfigs){
     }
     configData->configDescriptions = (ConfigDesc *)malloc(sizeof(ConfigDesc) * numConfigs);
     configData->numConfigs = numConfigs;
+    configData->json = NULL;
+    configData->jsonOffsets = NULL;
+    configData->tagIndex = NULL;
+    configData->tagIndexSize = 0;
 }
 
-void destroyConfigData(ConfigData *configData){
-    int numConfigs = configData->numConfigs;
+static unsigned int hashTag(const char *tag){
+    // FNV-1a.
+    unsigned int hash = 2166136261u;
+    while(*tag){
+        hash = (hash ^ (unsigned char)*tag++) * 16777619u;
+    }
+    return hash;
+}
+
+void buildConfigTagIndex(ConfigData *configData){
+    if(configData->tagIndex){
+        free(configData->tagIndex);
+    }
+    // Keep the table at most half full so probe sequences stay short.
+    int size = 16;
+    while(size < configData->numConfigs * 2){
+        size *= 2;
+    }
+    configData->tagIndex = (int *)malloc(sizeof(int) * size);
+    configData->tagIndexSize = size;
+    int slot;
+    for(slot = 0; slot < size; slot++){
+        configData->tagIndex[slot] = -1;
+    }
     int config;
-    for(config = 0; config < numConfigs; config++){
-        // Free input node weights.
-        int index;
-        for(index = 0; index < configData->configDescriptions[config].numInputNodes; index++){
-            if(configData->configDescriptions[config].inputNodes[index].weights){
-                free(configData->configDescriptions[config].inputNodes[index].weights);
-            }
+    for(config = 0; config < configData->numConfigs; config++){
+        const char *tag = configData->configDescriptions[config].tag;
+        if(!tag){
+            continue;
+        }
+        // Linear probing. A repeated tag keeps pointing at its first config.
+        slot = hashTag(tag) & (size - 1);
+        while(configData->tagIndex[slot] >= 0 && strcmp(configData->configDescriptions[configData->tagIndex[slot]].tag, tag) != 0){
+            slot = (slot + 1) & (size - 1);
+        }
+        if(configData->tagIndex[slot] < 0){
+            configData->tagIndex[slot] = config;
         }
-        // Free hidden node weights.
-        for(index = 0; index < configData->configDescriptions[config].numHiddenNodes; index++){
-            if(configData->configDescriptions[config].hiddenNodes[index].weights){
-                free(configData->configDescriptions[config].hiddenNodes[index].weights);
+    }
+}
+
+int findConfigIndexByTag(ConfigData *configData, const char *tag){
+    int config;
+    if(!configData->tagIndex){
+        // No index, for ConfigData filled in by hand.
+        for(config = 0; config < configData->numConfigs; config++){
+            if(configData->configDescriptions[config].tag && strcmp(configData->configDescriptions[config].tag, tag) == 0){
+                return config;
             }
         }
-        // Free config description nodes.
-        if(configData->configDescriptions[config].inputNodes){
-            free(configData->configDescriptions[config].inputNodes);
+        return -1;
+    }
+    int mask = configData->tagIndexSize - 1;
+    int slot = hashTag(tag) & mask;
+    while((config = configData->tagIndex[slot]) >= 0){
+        if(strcmp(configData->configDescriptions[config].tag, tag) == 0){
+            return config;
         }
-        if(configData->configDescriptions[config].hiddenNodes){
-            free(configData->configDescriptions[config].hiddenNodes);
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+ConfigDesc *findConfigByTag(ConfigData *configData, const char *tag){
+    int config = findConfigIndexByTag(configData, tag);
+    return config >= 0 ? &configData->configDescriptions[config] : NULL;
+}
+
+void destroyConfigDesc(ConfigDesc *configDesc){
+    // Free input node weights.
+    int index;
+    for(index = 0; index < configDesc->numInputNodes; index++){
+        if(configDesc->inputNodes[index].weights){
+            free(configDesc->inputNodes[index].weights);
         }
     }
+    // Free hidden node weights.
+    for(index = 0; index < configDesc->numHiddenNodes; index++){
+        if(configDesc->hiddenNodes[index].weights){
+            free(configDesc->hiddenNodes[index].weights);
+        }
+    }
+    // Free config description nodes and tag.
+    if(configDesc->inputNodes){
+        free(configDesc->inputNodes);
+    }
+    if(configDesc->hiddenNodes){
+        free(configDesc->hiddenNodes);
+    }
+    if(configDesc->tag){
+        free(configDesc->tag);
+    }
+    if(configDesc->mapped){
+        free(configDesc->mapped);
+    }
+}
+
+void destroyConfigData(ConfigData *configData){
+    int numConfigs = configData->numConfigs;
+    int config;
+    for(config = 0; config < numConfigs; config++){
+        destroyConfigDesc(&configData->configDescriptions[config]);
+    }
     // Free config description.
     if(configData->configDescriptions){
         free(configData->configDescriptions);
     }
+    if(configData->jsonOffsets){
+        free(configData->jsonOffsets);
+    }
+    if(configData->tagIndex){
+        free(configData->tagIndex);
+    }
+    configData->json = NULL;
+    configData->jsonOffsets = NULL;
+    configData->tagIndex = NULL;
+    configData->tagIndexSize = 0;
     configData->initialised = 0;
 }
@@ -21,26 +21,62 @@ typedef struct ConfigNode {
     double *weights;
 } ConfigNode;
 
+// Vectors of a pre-mapped config image, in the order they are stored: the row-major hidden
+// weight matrix (numHiddenNodes x numNodes), the input weights (numInputNodes), then one
+// vector of numNodes values per node parameter, input nodes first.
+typedef enum ConfigMappedVector {
+    CONFIG_MAPPED_WEIGHTS = 0,
+    CONFIG_MAPPED_INPUT_WEIGHTS,
+    CONFIG_MAPPED_GAIN,
+    CONFIG_MAPPED_GAIN_BIAS,
+    CONFIG_MAPPED_T,
+    CONFIG_MAPPED_SINE_COEFFICIENT,
+    CONFIG_MAPPED_TANH_COEFFICIENT,
+    CONFIG_MAPPED_FREQUENCY_MULTIPLIER,
+    CONFIG_MAPPED_VECTORS
+} ConfigMappedVector;
+
+// A ConfigDesc must come from initConfigDesc or be zero-initialised, so that mapped starts NULL.
+// Editing a ConfigNode after mapCTRNNConfig leaves the image stale: map the config again, or drop
+// the image with unmapCTRNNConfig.
 typedef struct ConfigDesc {
     ConfigNode *inputNodes;
     ConfigNode *hiddenNodes;
     int numInputNodes;
     int numHiddenNodes;
     char *tag;
+    double *mapped; // Engine-ready image built by mapCTRNNConfig, or NULL.
 } ConfigDesc;
     
+// Marks a lazily rendered config that has been built.
+#define CONFIG_BUILT ((size_t)-1)
+
 typedef struct ConfigData {
     ConfigDesc *configDescriptions;
     int numConfigs;
     int initialised;
+    const char *json; // Lazy rendering only. Source of the configs that are not built yet.
+    size_t *jsonOffsets; // Lazy rendering only. Start of each config in json, or CONFIG_BUILT.
+    int *tagIndex; // Open-addressing hash table of config indices by tag, -1 for empty slots.
+    int tagIndexSize; // Number of slots, a power of two.
 } ConfigData;
 
 void destroyConfigData(ConfigData *configData);
+
+void destroyConfigDesc(ConfigDesc *configDesc);
     
 void initConfigData(ConfigData *configData, int numConfigs);
 
 void initConfigDesc(ConfigDesc *configDesc, int numInputNodes, int numberHiddenNodes);
 
+void buildConfigTagIndex(ConfigData *configData);
+
+size_t getConfigMappedOffset(ConfigDesc *configDesc, ConfigMappedVector vector);
+
+int findConfigIndexByTag(ConfigData *configData, const char *tag);
+
+ConfigDesc *findConfigByTag(ConfigData *configData, const char *tag);
+
 #ifdef __cplusplus 
 }
 #endif
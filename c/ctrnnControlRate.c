@@ -0,0 +1,138 @@
+#include <math.h>
+#include "ctrnnControlRate.h"
+
+#define CONTROL_PI 3.141592653589793
+// Zero crossings of the BLEP's windowed sinc on each side of its centre.
+#define BLEP_ZERO_CROSSINGS 1
+// Integration points per audio sample when building the BLEP.
+#define BLEP_OVERSAMPLING 16
+
+// Blackman-windowed sinc over one control step, u in [0, 1], centred on the middle of the step.
+static double blepKernel(double u){
+    double x = BLEP_ZERO_CROSSINGS * (2 * u - 1);
+    double sinc = x == 0 ? 1 : sin(CONTROL_PI * x) / (CONTROL_PI * x);
+    double window = 0.42 - 0.5 * cos(2 * CONTROL_PI * u) + 0.08 * cos(4 * CONTROL_PI * u);
+    return sinc * window;
+}
+// Integrate the kernel up to each sample of a step, so the last sample lands on the new control point.
+static void buildBlep(double *blep, int interval){
+    int numPoints = interval * BLEP_OVERSAMPLING;
+    double sum = 0;
+    int point;
+    int sample;
+    for(point = 0; point < numPoints; point++){
+        sum += blepKernel((point + 0.5) / numPoints);
+        if((point + 1) % BLEP_OVERSAMPLING == 0){
+            blep[point / BLEP_OVERSAMPLING] = sum;
+        }
+    }
+    for(sample = 0; sample < interval; sample++){
+        blep[sample] /= sum;
+    }
+}
+// Make the network's current outputs the newest control point, reusing the oldest point's storage.
+static void pushControlPoint(CTRNNControlRate *control){
+    const double *hiddenOutput = control->ctrnn->output + control->ctrnn->numInputNodes;
+    double *newest = control->points[0];
+    int point;
+    int i;
+    for(point = 0; point < CTRNN_CONTROL_POINTS - 1; point++){
+        control->points[point] = control->points[point + 1];
+    }
+    control->points[CTRNN_CONTROL_POINTS - 1] = newest;
+    for(i = 0; i < control->numOutputNodes; i++){
+        newest[i] = hiddenOutput[i];
+    }
+}
+// Write the up-sampled outputs at the current position to frame[i * stride].
+static void interpolateControlPoints(CTRNNControlRate *control, double *frame, size_t stride){
+    const double *p0 = control->points[0];
+    const double *p1 = control->points[1];
+    const double *p2 = control->points[2];
+    const double *p3 = control->points[3];
+    double t = (double)control->position / control->interval;
+    int i;
+    if(control->interpolation == CTRNN_INTERPOLATE_HERMITE){
+        for(i = 0; i < control->numOutputNodes; i++){
+            frame[i * stride] = p1[i] + 0.5 * t * (p2[i] - p0[i] + t * (2 * p0[i] - 5 * p1[i] + 4 * p2[i] - p3[i] + t * (3 * (p1[i] - p2[i]) + p3[i] - p0[i])));
+        }
+    } else {
+        if(control->interpolation == CTRNN_INTERPOLATE_BLEP){
+            t = control->blep[control->position - 1];
+        }
+        for(i = 0; i < control->numOutputNodes; i++){
+            frame[i * stride] = p2[i] + t * (p3[i] - p2[i]);
+        }
+    }
+}
+// Audio samples per control step for a control rate in Hz. Always at least 1.
+int ctrnnControlInterval(double sampleRate, double controlRate){
+    int interval = (int)(sampleRate / controlRate + 0.5);
+    return interval < 1 ? 1 : interval;
+}
+// Initialise control-rate rendering of ctrnn with numOutputNodes outputs. timeStep is the step the
+// network would take per audio sample, each control step advances it by timeStep * interval.
+void initialiseCTRNNControlRate(CTRNNControlRate *control, CTRNN *ctrnn, double timeStep, int interval, int numOutputNodes, CTRNNInterpolation interpolation){
+    int point;
+    if(control->initialised){
+        destroyCTRNNControlRate(control);
+    }
+    control->ctrnn = ctrnn;
+    control->interpolation = interpolation;
+    control->interval = interval < 1 ? 1 : interval;
+    control->numOutputNodes = numOutputNodes;
+    control->memory = malloc(sizeof(double) * ((size_t)CTRNN_CONTROL_POINTS * numOutputNodes + control->interval));
+    double *cursor = (double *)control->memory;
+    for(point = 0; point < CTRNN_CONTROL_POINTS; point++){
+        control->points[point] = cursor;
+        cursor += numOutputNodes;
+    }
+    control->blep = cursor;
+    buildBlep(control->blep, control->interval);
+    changeCTRNNTimestep(ctrnn, timeStep * control->interval);
+    resetCTRNNControlRate(control);
+    control->initialised = 1;
+}
+// Restart from the network's current outputs, for example after resetCTRNN.
+void resetCTRNNControlRate(CTRNNControlRate *control){
+    int point;
+    for(point = 0; point < CTRNN_CONTROL_POINTS; point++){
+        pushControlPoint(control);
+    }
+    control->position = 0;
+}
+// Render numSamples audio-rate output frames. The network is stepped at the start of each control
+// step, reading its inputs from the frame at inputs + sample * inputStride (NULL inputs keep the
+// last fed values). Outputs are laid out as in renderCTRNNBlock.
+void renderCTRNNControlRateBlock(CTRNNControlRate *control, const double *inputs, int inputStride, double *outputs, CTRNNOutputLayout layout, int numSamples){
+    CTRNN *ctrnn = control->ctrnn;
+    int sample;
+    int i;
+    for(sample = 0; sample < numSamples; sample++){
+        if(control->position == 0){
+            if(inputs){
+                const double *frame = inputs + (size_t)sample * inputStride;
+                for(i = 0; i < ctrnn->numInputNodes; i++){
+                    ctrnn->inputs[i] = frame[i];
+                }
+            }
+            stepCTRNN(ctrnn);
+            pushControlPoint(control);
+        }
+        control->position++;
+        if(layout == CTRNN_OUTPUT_PLANAR){
+            interpolateControlPoints(control, outputs + sample, (size_t)numSamples);
+        } else {
+            interpolateControlPoints(control, outputs + (size_t)sample * control->numOutputNodes, 1);
+        }
+        if(control->position == control->interval){
+            control->position = 0;
+        }
+    }
+}
+// Free memory assigned for control-rate rendering. The network stays with the caller.
+void destroyCTRNNControlRate(CTRNNControlRate *control){
+    free(control->memory);
+    control->memory = NULL;
+    control->initialised = 0;
+}
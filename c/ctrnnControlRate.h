@@ -0,0 +1,52 @@
+#ifndef ctrnnControlRate_h
+#define ctrnnControlRate_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctrnn.h"
+
+// How control-rate outputs are up-sampled to the audio rate.
+typedef enum CTRNNInterpolation {
+    CTRNN_INTERPOLATE_LINEAR = 0, // Straight lines between control points. One control step of latency.
+    CTRNN_INTERPOLATE_HERMITE, // Catmull-Rom cubic through four control points. Two control steps of latency.
+    CTRNN_INTERPOLATE_BLEP // Each change eased in along a band-limited step. One control step of latency.
+} CTRNNInterpolation;
+
+// Control points kept per output node.
+#define CTRNN_CONTROL_POINTS 4
+
+// Steps a CTRNN once every interval audio samples and up-samples its outputs, so that
+// LFO-rate networks cost a fraction of stepping at the audio rate.
+typedef struct CTRNNControlRate {
+
+    CTRNN *ctrnn; // Stepped network, owned by the caller.
+    CTRNNInterpolation interpolation;
+    int interval; // Audio samples per control step.
+    int position; // Samples rendered in the current control step.
+    int numOutputNodes;
+    double *points[CTRNN_CONTROL_POINTS]; // Control outputs of each output node, oldest first.
+    double *blep; // Share of the newest control point at each sample of a step. BLEP only.
+    void *memory; // Single block holding the vectors above.
+    int initialised;
+
+} CTRNNControlRate;
+
+int ctrnnControlInterval(double sampleRate, double controlRate);
+
+void initialiseCTRNNControlRate(CTRNNControlRate *control, CTRNN *ctrnn, double timeStep, int interval, int numOutputNodes, CTRNNInterpolation interpolation);
+
+void resetCTRNNControlRate(CTRNNControlRate *control);
+
+void renderCTRNNControlRateBlock(CTRNNControlRate *control, const double *inputs, int inputStride, double *outputs, CTRNNOutputLayout layout, int numSamples);
+
+void destroyCTRNNControlRate(CTRNNControlRate *control);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ctrnnControlRate_h */
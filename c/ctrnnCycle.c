@@ -0,0 +1,314 @@
+#include <math.h>
+#include <string.h>
+#include "ctrnnCycle.h"
+
+// Periods a candidate must repeat for, integrating live, before it is played back. Chaotic networks
+// can come back close to the anchor and follow their earlier path for a while before they drift.
+#define CYCLE_VERIFY_PERIODS 4
+// Longest wait between searches once they keep failing, in searches of maxPeriod steps.
+#define CYCLE_MAX_BACKOFF 8
+// Newton iterations taken when refining where a step passed the anchor.
+#define CYCLE_REFINE_ITERATIONS 3
+
+// Whether every node's y is within the tolerance of a stored state.
+static int matchesState(CTRNNCycle *cycle, const double *state){
+    const double *y = cycle->ctrnn->y;
+    int node;
+    for(node = 0; node < cycle->ctrnn->numNodes; node++){
+        if(fabs(y[node] - state[node]) > cycle->tolerance){
+            return 0;
+        }
+    }
+    return 1;
+}
+// Store the network's node states and hidden outputs as step index since the anchor.
+static void storeState(CTRNNCycle *cycle, int index){
+    CTRNN *ctrnn = cycle->ctrnn;
+    memcpy(cycle->states + (size_t)index * ctrnn->numNodes, ctrnn->y, sizeof(double) * ctrnn->numNodes);
+    memcpy(cycle->outputs + (size_t)index * cycle->numOutputNodes, ctrnn->output + ctrnn->numInputNodes, sizeof(double) * cycle->numOutputNodes);
+}
+// The stored step after step and the distance to it. The last stored step leads back to the
+// anchor, which is the remainder of the period away.
+static int nextStored(CTRNNCycle *cycle, int step, double *spacing){
+    if(step + 1 < cycle->numStates){
+        *spacing = 1;
+        return step + 1;
+    }
+    *spacing = cycle->period - step;
+    return 0;
+}
+// The stored step before step and the distance to it.
+static int previousStored(CTRNNCycle *cycle, int step, double *spacing){
+    if(step > 0){
+        *spacing = 1;
+        return step - 1;
+    }
+    *spacing = cycle->period - (cycle->numStates - 1);
+    return cycle->numStates - 1;
+}
+// Interpolate a table of stored steps, width values per step, at the current phase. Cubic Hermite
+// through the steps either side, with tangents from their neighbours, so that the error stays well
+// under the tolerance even when the network moves a long way each step.
+static void interpolateStored(CTRNNCycle *cycle, const double *table, int width, double *out){
+    int step = (int)cycle->phase;
+    double before;
+    double span;
+    double after;
+    int p0 = previousStored(cycle, step, &before);
+    int p2 = nextStored(cycle, step, &span);
+    int p3 = nextStored(cycle, p2, &after);
+    const double *y0 = table + (size_t)p0 * width;
+    const double *y1 = table + (size_t)step * width;
+    const double *y2 = table + (size_t)p2 * width;
+    const double *y3 = table + (size_t)p3 * width;
+    double t = (cycle->phase - step) / span;
+    double h00 = (1 + 2 * t) * (1 - t) * (1 - t);
+    double h10 = t * (1 - t) * (1 - t) * span / (before + span);
+    double h01 = t * t * (3 - 2 * t);
+    double h11 = t * t * (t - 1) * span / (span + after);
+    int i;
+    for(i = 0; i < width; i++){
+        out[i] = h00 * y1[i] + h10 * (y2[i] - y0[i]) + h01 * y2[i] + h11 * (y3[i] - y1[i]);
+    }
+}
+// Whether every node's y is within the tolerance of the captured period at the current phase.
+static int matchesPeriod(CTRNNCycle *cycle){
+    interpolateStored(cycle, cycle->states, cycle->ctrnn->numNodes, cycle->point);
+    return matchesState(cycle, cycle->point);
+}
+// Refine where the network passed closest to the anchor with a quadratic through the last two stored
+// states and the network's state. The straight step is only a first guess, and the period is
+// measured from it, so any error there builds up as drift during playback.
+static double refineCrossing(CTRNNCycle *cycle, double fraction){
+    const double *y = cycle->ctrnn->y;
+    const double *anchor = cycle->states;
+    const double *last = cycle->states + (size_t)(cycle->numStates - 1) * cycle->ctrnn->numNodes;
+    const double *before = last - cycle->ctrnn->numNodes;
+    int numNodes = cycle->ctrnn->numNodes;
+    int iteration;
+    int node;
+    for(iteration = 0; iteration < CYCLE_REFINE_ITERATIONS; iteration++){
+        double slope = 0;
+        double curvature = 0;
+        for(node = 0; node < numNodes; node++){
+            double velocity = 0.5 * (y[node] - before[node]);
+            double acceleration = y[node] - 2 * last[node] + before[node];
+            double offset = last[node] + fraction * (velocity + 0.5 * fraction * acceleration) - anchor[node];
+            double tangent = velocity + fraction * acceleration;
+            slope += offset * tangent;
+            curvature += tangent * tangent + offset * acceleration;
+        }
+        if(curvature <= 0){
+            break;
+        }
+        fraction -= slope / curvature;
+        fraction = fraction < 0 ? 0 : fraction > 1 ? 1 : fraction;
+    }
+    return fraction;
+}
+// Where the step from the last stored state to the network's state passes closest to the anchor,
+// as a fraction of the step. Negative when it does not pass within the tolerance.
+static double anchorCrossing(CTRNNCycle *cycle){
+    const double *y = cycle->ctrnn->y;
+    const double *anchor = cycle->states;
+    const double *last = cycle->states + (size_t)(cycle->numStates - 1) * cycle->ctrnn->numNodes;
+    int numNodes = cycle->ctrnn->numNodes;
+    double along = 0;
+    double length = 0;
+    double fraction;
+    int node;
+    for(node = 0; node < numNodes; node++){
+        // Most steps pass nowhere near the anchor, so first rule out any node where both ends miss it.
+        if(fmin(last[node], y[node]) > anchor[node] + cycle->tolerance || fmax(last[node], y[node]) < anchor[node] - cycle->tolerance){
+            return -1;
+        }
+    }
+    for(node = 0; node < numNodes; node++){
+        along += (anchor[node] - last[node]) * (y[node] - last[node]);
+        length += (y[node] - last[node]) * (y[node] - last[node]);
+    }
+    fraction = length > 0 ? along / length : 0;
+    fraction = fraction < 0 ? 0 : fraction > 1 ? 1 : fraction;
+    for(node = 0; node < numNodes; node++){
+        if(fabs(last[node] + fraction * (y[node] - last[node]) - anchor[node]) > cycle->tolerance){
+            return -1;
+        }
+    }
+    return cycle->numStates > 1 ? refineCrossing(cycle, fraction) : fraction;
+}
+// Make the network's current state the anchor of a new search.
+static void restartSearch(CTRNNCycle *cycle){
+    cycle->state = CTRNN_CYCLE_SEARCHING;
+    storeState(cycle, 0);
+    cycle->numStates = 1;
+    cycle->departed = 0;
+    cycle->period = 0;
+    cycle->phase = 0;
+    cycle->verifySteps = 0;
+    cycle->idleSteps = 0;
+}
+// Move the phase on by one step, wrapping at the end of the period.
+static void advancePhase(CTRNNCycle *cycle){
+    cycle->phase += 1;
+    if(cycle->phase >= cycle->period){
+        cycle->phase -= cycle->period;
+    }
+}
+// Check a live step against the search or against the candidate period.
+static void trackCycle(CTRNNCycle *cycle){
+    if(cycle->state == CTRNN_CYCLE_VERIFYING){
+        advancePhase(cycle);
+        if(!matchesPeriod(cycle)){
+            restartSearch(cycle);
+        } else if(--cycle->verifySteps == 0){
+            // The period repeated, play it from here.
+            cycle->state = CTRNN_CYCLE_PLAYING;
+            interpolateStored(cycle, cycle->outputs, cycle->numOutputNodes, cycle->playback);
+        }
+        return;
+    }
+    // Only a return after leaving the anchor's neighbourhood is a cycle. States that never leave it are fixed points.
+    if(cycle->departed){
+        double crossing = anchorCrossing(cycle);
+        if(crossing >= 0 && cycle->numStates - 1 + crossing > 1){
+            cycle->period = cycle->numStates - 1 + crossing;
+            cycle->phase = 1 - crossing;
+            cycle->verifySteps = (int)ceil(cycle->period * CYCLE_VERIFY_PERIODS);
+            cycle->state = CTRNN_CYCLE_VERIFYING;
+            return;
+        }
+    }
+    if(cycle->numStates == cycle->maxPeriod){
+        // Networks that never repeat would pay for the search every step, so wait longer after each miss.
+        cycle->misses += cycle->misses < CYCLE_MAX_BACKOFF;
+        restartSearch(cycle);
+        cycle->idleSteps = cycle->misses * cycle->maxPeriod;
+    } else {
+        if(!cycle->departed){
+            cycle->departed = !matchesState(cycle, cycle->states);
+        }
+        storeState(cycle, cycle->numStates++);
+    }
+}
+// Restore the node states of the current point in the period, so live integration carries on from it.
+static void resumeLive(CTRNNCycle *cycle){
+    CTRNN *ctrnn = cycle->ctrnn;
+    int node;
+    interpolateStored(cycle, cycle->states, ctrnn->numNodes, ctrnn->y);
+    for(node = 0; node < ctrnn->numNodes; node++){
+        ctrnn->tempOutput[node] = ctrnn->gain[node] * ctrnn->y[node] - ctrnn->gainBias[node];
+    }
+    ctrnn->sineTransfer(ctrnn->tempOutput, ctrnn->tanhCoefficient, ctrnn->sineCoefficient, ctrnn->frequencyMultiplier, ctrnn->output, ctrnn->numNodes);
+}
+// Whether the network's inputs differ from those the period is being captured under.
+static int inputsChanged(CTRNNCycle *cycle){
+    int i;
+    for(i = 0; i < cycle->ctrnn->numInputNodes; i++){
+        if(cycle->ctrnn->inputs[i] != cycle->inputs[i]){
+            return 1;
+        }
+    }
+    return 0;
+}
+// Initialise cycle detection on ctrnn for its first numOutputNodes outputs. Periods of up to
+// maxPeriod steps are captured when every node's y repeats to within tolerance.
+void initialiseCTRNNCycle(CTRNNCycle *cycle, CTRNN *ctrnn, int numOutputNodes, int maxPeriod, double tolerance){
+    if(cycle->initialised){
+        destroyCTRNNCycle(cycle);
+    }
+    cycle->ctrnn = ctrnn;
+    cycle->tolerance = tolerance;
+    cycle->maxPeriod = maxPeriod < 1 ? 1 : maxPeriod;
+    cycle->numOutputNodes = numOutputNodes;
+    cycle->memory = malloc(sizeof(double) * ((size_t)cycle->maxPeriod * (ctrnn->numNodes + numOutputNodes) + ctrnn->numNodes + ctrnn->numInputNodes + numOutputNodes));
+    cycle->states = (double *)cycle->memory;
+    cycle->outputs = cycle->states + (size_t)cycle->maxPeriod * ctrnn->numNodes;
+    cycle->point = cycle->outputs + (size_t)cycle->maxPeriod * numOutputNodes;
+    cycle->inputs = cycle->point + ctrnn->numNodes;
+    cycle->playback = cycle->inputs + ctrnn->numInputNodes;
+    resetCTRNNCycle(cycle);
+    cycle->initialised = 1;
+}
+// Go back to live integration from the network's current state and search again. Call after
+// changing the network itself, for example with resetCTRNN or changeCTRNNTimestep.
+void resetCTRNNCycle(CTRNNCycle *cycle){
+    memcpy(cycle->inputs, cycle->ctrnn->inputs, sizeof(double) * cycle->ctrnn->numInputNodes);
+    cycle->misses = 0;
+    restartSearch(cycle);
+}
+// Advance one step, by playing back the captured period or by integrating. Inputs fed to the
+// network with feedCTRNNInputs since the last update end playback.
+void updateCTRNNCycle(CTRNNCycle *cycle){
+    CTRNN *ctrnn = cycle->ctrnn;
+    if(inputsChanged(cycle)){
+        if(cycle->state == CTRNN_CYCLE_PLAYING){
+            resumeLive(cycle);
+        }
+        memcpy(cycle->inputs, ctrnn->inputs, sizeof(double) * ctrnn->numInputNodes);
+        stepCTRNN(ctrnn);
+        cycle->misses = 0;
+        restartSearch(cycle);
+        return;
+    }
+    if(cycle->state == CTRNN_CYCLE_PLAYING){
+        advancePhase(cycle);
+        interpolateStored(cycle, cycle->outputs, cycle->numOutputNodes, cycle->playback);
+        return;
+    }
+    stepCTRNN(ctrnn);
+    if(cycle->idleSteps > 0){
+        if(--cycle->idleSteps == 0){
+            restartSearch(cycle);
+        }
+        return;
+    }
+    trackCycle(cycle);
+}
+// Hidden outputs of the current step, from the captured period during playback.
+static const double *cycleOutput(CTRNNCycle *cycle){
+    if(cycle->state == CTRNN_CYCLE_PLAYING){
+        return cycle->playback;
+    }
+    return cycle->ctrnn->output + cycle->ctrnn->numInputNodes;
+}
+// Get the outputs. The network's own outputs are stale during playback, so read them here.
+void getCTRNNCycleOutput(CTRNNCycle *cycle, double * outputs, int numOutputNodes){
+    const double *hiddenOutput = cycleOutput(cycle);
+    int i;
+    for(i = 0; i < numOutputNodes; i++){
+        outputs[i] = hiddenOutput[i];
+    }
+}
+// Render numSteps steps in one call, writing the outputs cycle was initialised with. See renderCTRNNBlock.
+void renderCTRNNCycleBlock(CTRNNCycle *cycle, const double *inputs, int inputStride, double *outputs, CTRNNOutputLayout layout, int numSteps){
+    CTRNN *ctrnn = cycle->ctrnn;
+    int numOutputNodes = cycle->numOutputNodes;
+    int step;
+    int i;
+    for(step = 0; step < numSteps; step++){
+        if(inputs){
+            const double *inputFrame = inputs + (size_t)step * inputStride;
+            for(i = 0; i < ctrnn->numInputNodes; i++){
+                ctrnn->inputs[i] = inputFrame[i];
+            }
+        }
+        updateCTRNNCycle(cycle);
+        const double *hiddenOutput = cycleOutput(cycle);
+        if(layout == CTRNN_OUTPUT_PLANAR){
+            for(i = 0; i < numOutputNodes; i++){
+                outputs[(size_t)i * numSteps + step] = hiddenOutput[i];
+            }
+        } else {
+            double *frame = outputs + (size_t)step * numOutputNodes;
+            for(i = 0; i < numOutputNodes; i++){
+                frame[i] = hiddenOutput[i];
+            }
+        }
+    }
+}
+// Free memory assigned for cycle detection. The network stays with the caller.
+void destroyCTRNNCycle(CTRNNCycle *cycle){
+    free(cycle->memory);
+    cycle->memory = NULL;
+    cycle->initialised = 0;
+}
@@ -0,0 +1,63 @@
+#ifndef ctrnnCycle_h
+#define ctrnnCycle_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctrnn.h"
+
+// What a CTRNNCycle is doing with its network.
+typedef enum CTRNNCycleState {
+    CTRNN_CYCLE_SEARCHING = 0, // Integrating live and waiting for the state to come back to the anchor, or for the next search.
+    CTRNN_CYCLE_VERIFYING, // Integrating live and checking that a candidate period repeats.
+    CTRNN_CYCLE_PLAYING // Playing the captured period back without integrating.
+} CTRNNCycleState;
+
+// Steps a CTRNN until it settles into a periodic attractor, then plays one captured period
+// back as a wavetable. Periods need not be whole numbers of steps, playback interpolates
+// between the captured steps. Live integration resumes, from the node states of the current
+// point in the period, as soon as the inputs change.
+typedef struct CTRNNCycle {
+
+    CTRNN *ctrnn; // Stepped network, owned by the caller.
+    CTRNNCycleState state;
+    double tolerance; // Largest difference in any node's y for two states to count as the same.
+    int maxPeriod; // Longest period in steps that can be captured.
+    int numOutputNodes;
+    int numStates; // Steps stored since the anchor.
+    int departed; // Set once the search has moved further than the tolerance from the anchor.
+    double period; // Length of the candidate or captured period in steps.
+    double phase; // Position in the period, in steps.
+    int verifySteps; // Steps left before the candidate period is accepted.
+    int misses; // Searches in a row that reached maxPeriod without a return.
+    int idleSteps; // Live steps left before the next search starts.
+    double *states; // y of each step since the anchor, the anchor first (maxPeriod x numNodes).
+    double *outputs; // Hidden outputs of each step since the anchor (maxPeriod x numOutputNodes).
+    double *point; // Interpolated y at the current phase.
+    double *inputs; // Inputs the period is being captured under.
+    double *playback; // Interpolated hidden outputs at the current phase.
+    void *memory; // Single block holding the vectors above.
+    int initialised;
+
+} CTRNNCycle;
+
+void initialiseCTRNNCycle(CTRNNCycle *cycle, CTRNN *ctrnn, int numOutputNodes, int maxPeriod, double tolerance);
+
+void resetCTRNNCycle(CTRNNCycle *cycle);
+
+void updateCTRNNCycle(CTRNNCycle *cycle);
+
+void getCTRNNCycleOutput(CTRNNCycle *cycle, double * outputs, int numOutputNodes);
+
+void renderCTRNNCycleBlock(CTRNNCycle *cycle, const double *inputs, int inputStride, double *outputs, CTRNNOutputLayout layout, int numSteps);
+
+void destroyCTRNNCycle(CTRNNCycle *cycle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ctrnnCycle_h */
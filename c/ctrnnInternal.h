@@ -0,0 +1,39 @@
+// Internals of the CTRNN step, shared by the inline stepCTRNN and the integrators in ctrnn.c and
+// ctrnnAdaptive.c. Not part of the public API and liable to change: include ctrnn.h instead,
+// which includes this file after defining CTRNN.
+
+#ifndef ctrnnInternal_h
+#define ctrnnInternal_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void evaluateCTRNNYDot(CTRNN *ctrnn, const double *y, const double *output, double *yDot);
+
+void evaluateCTRNNOutput(CTRNN *ctrnn, const double *y, double *output);
+
+void stepCTRNNStages(CTRNN *ctrnn);
+
+// Count the steps in a row on which no node's yDot * rate, its change over the step, exceeded
+// freezeThreshold * timeStep, and freeze the network after freezeSteps of them.
+static inline void settleCTRNN(CTRNN *ctrnn, const double *yDot){
+    double limit = ctrnn->freezeThreshold * ctrnn->timeStep;
+    int node;
+    for(node = 0; node < ctrnn->numNodes && fabs(yDot[node] * ctrnn->rate[node]) <= limit; node++){
+    }
+    ctrnn->settledSteps = node == ctrnn->numNodes ? ctrnn->settledSteps + 1 : 0;
+    if(ctrnn->settledSteps >= ctrnn->freezeSteps){
+        for(node = 0; node < ctrnn->numInputNodes; node++){
+            ctrnn->frozenInputs[node] = ctrnn->inputs[node];
+        }
+        ctrnn->settledSteps = 0;
+        ctrnn->frozen = 1;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ctrnnInternal_h */
@@ -0,0 +1,334 @@
+#include "ctrnnKernels.h"
+#include <math.h>
+#include "mapParams.h"
+
+// Scalar kernels sum in node order and call libm, so their results do not depend on the CPU.
+static void matVecScalar(const double *weights, const double *state, double *sums, int numRows, int numCols){
+    int r;
+    int c;
+    for(r = 0; r < numRows; r++){
+        const double *row = weights + (size_t)r * numCols;
+        double sum = sums[r];
+        for(c = 0; c < numCols; c++){
+            sum += state[c] * row[c];
+        }
+        sums[r] = sum;
+    }
+}
+
+static void laneMatVecScalar(const double *weights, const double *state, double *sums, int numRows, int numCols, int numLanes){
+    int r;
+    int c;
+    int lane;
+    for(r = 0; r < numRows; r++){
+        const double *row = weights + (size_t)r * numCols * numLanes;
+        double *rowSums = sums + (size_t)r * numLanes;
+        for(c = 0; c < numCols; c++){
+            for(lane = 0; lane < numLanes; lane++){
+                rowSums[lane] += state[(size_t)c * numLanes + lane] * row[(size_t)c * numLanes + lane];
+            }
+        }
+    }
+}
+
+static void sineTransferScalar(const double *activation, const double *tanhCoefficient, const double *sineCoefficient, const double *frequencyMultiplier, double *out, int n){
+    int i;
+    for(i = 0; i < n; i++){
+        out[i] = tanhCoefficient[i] * tanh(activation[i]) + sineCoefficient[i] * sin(frequencyMultiplier[i] * activation[i]);
+    }
+}
+
+static void sineTransferFastScalar(const double *activation, const double *tanhCoefficient, const double *sineCoefficient, const double *frequencyMultiplier, double *out, int n){
+    int i;
+    for(i = 0; i < n; i++){
+        out[i] = tanhCoefficient[i] * fastTanh(activation[i]) + sineCoefficient[i] * fastSin(frequencyMultiplier[i] * activation[i]);
+    }
+}
+
+static void sineTransferTable(const double *activation, const double *tanhCoefficient, const double *sineCoefficient, const double *frequencyMultiplier, double *out, int n){
+    int i;
+    for(i = 0; i < n; i++){
+        out[i] = tanhCoefficient[i] * tableTanh(activation[i]) + sineCoefficient[i] * tableSin(frequencyMultiplier[i] * activation[i]);
+    }
+}
+
+static void matVecFloatScalar(const float *weights, const float *state, float *sums, int numRows, int numCols){
+    int r;
+    int c;
+    for(r = 0; r < numRows; r++){
+        const float *row = weights + (size_t)r * numCols;
+        float sum = sums[r];
+        for(c = 0; c < numCols; c++){
+            sum += state[c] * row[c];
+        }
+        sums[r] = sum;
+    }
+}
+
+static void sineTransferFloatScalar(const float *activation, const float *tanhCoefficient, const float *sineCoefficient, const float *frequencyMultiplier, float *out, int n){
+    int i;
+    for(i = 0; i < n; i++){
+        out[i] = tanhCoefficient[i] * tanhf(activation[i]) + sineCoefficient[i] * sinf(frequencyMultiplier[i] * activation[i]);
+    }
+}
+
+static const CTRNNKernels scalarKernels = {CTRNN_KERNELS_SCALAR, matVecScalar, laneMatVecScalar, sineTransferScalar, sineTransferFastScalar, matVecFloatScalar, sineTransferFloatScalar};
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PLECTO_X86_KERNELS 1
+#endif
+
+#ifdef PLECTO_X86_KERNELS
+
+#include <immintrin.h>
+
+// Constants of the double-precision vector math (Cephes). The single-precision
+// constants are written inline in ctrnnKernelsFloatImpl.h.
+#define KERNEL_ROUND_MAGIC 6755399441055744.0 // 1.5 * 2^52, rounds to an integer when added.
+#define KERNEL_EXP_BIAS_MAGIC 4503599627371519.0 // 2^52 + 1023.
+#define KERNEL_SIGN_MASK -0.0
+#define KERNEL_LOG2E 1.4426950408889634
+#define KERNEL_EXP_C1 6.93145751953125E-1
+#define KERNEL_EXP_C2 1.42860682030941723212E-6
+#define KERNEL_EXP_P0 1.26177193074810590878E-4
+#define KERNEL_EXP_P1 3.02994407707441961300E-2
+#define KERNEL_EXP_P2 9.99999999999999999910E-1
+#define KERNEL_EXP_Q0 3.00198505138664455042E-6
+#define KERNEL_EXP_Q1 2.52448340349684104192E-3
+#define KERNEL_EXP_Q2 2.27265548208155028766E-1
+#define KERNEL_EXP_Q3 2.00000000000000000009E0
+#define KERNEL_TANH_P0 -9.64399179425052238628E-1
+#define KERNEL_TANH_P1 -9.92877231001918586564E1
+#define KERNEL_TANH_P2 -1.61468768441708447952E3
+#define KERNEL_TANH_Q0 1.12811678491632931402E2
+#define KERNEL_TANH_Q1 2.23548839060100448583E3
+#define KERNEL_TANH_Q2 4.84406305325125486048E3
+#define KERNEL_INV_PI 0.3183098861837907
+// pi split so that n * KERNEL_PI_1 and n * KERNEL_PI_2 are exact.
+#define KERNEL_PI_1 3.141592502593994
+#define KERNEL_PI_2 1.5099578831723193e-07
+#define KERNEL_PI_3 1.0780605716316238e-14
+// Taylor coefficients (-1)^k / (2k + 1)!.
+#define KERNEL_SIN_S1 -0.16666666666666666
+#define KERNEL_SIN_S2 0.008333333333333333
+#define KERNEL_SIN_S3 -0.0001984126984126984
+#define KERNEL_SIN_S4 2.7557319223985893e-06
+#define KERNEL_SIN_S5 -2.505210838544172e-08
+#define KERNEL_SIN_S6 1.6059043836821613e-10
+#define KERNEL_SIN_S7 -7.647163731819816e-13
+#define KERNEL_SIN_S8 2.8114572543455206e-15
+#define KERNEL_SIN_S9 -8.22063524662433e-18
+#define KERNEL_SIN_S10 1.9572941063391263e-20
+#define KERNEL_SIN_S11 -3.868170170630684e-23
+// CTRNN_TRANSFER_FAST uses a [7/6] Pade tanh and the first five sin terms, as fastSineTransferFunction does.
+#define KERNEL_PADE_N0 135135.0
+#define KERNEL_PADE_N1 17325.0
+#define KERNEL_PADE_N2 378.0
+#define KERNEL_PADE_D1 62370.0
+#define KERNEL_PADE_D2 3150.0
+#define KERNEL_PADE_D3 28.0
+
+// SSE2, double precision
+#define V __m128d
+#define VMASK __m128d
+#define VW 2
+#define KERNEL_TARGET __attribute__((target("sse2")))
+#define KERNEL_NAME(name) name##Sse2
+#define VLOAD(p) _mm_loadu_pd(p)
+#define VSTORE(p, a) _mm_storeu_pd(p, a)
+#define VSET1(x) _mm_set1_pd(x)
+#define VADD(a, b) _mm_add_pd(a, b)
+#define VSUB(a, b) _mm_sub_pd(a, b)
+#define VMUL(a, b) _mm_mul_pd(a, b)
+#define VDIV(a, b) _mm_div_pd(a, b)
+#define VMIN(a, b) _mm_min_pd(a, b)
+#define VMAX(a, b) _mm_max_pd(a, b)
+#define VFMA(a, b, c) _mm_add_pd(_mm_mul_pd(a, b), c)
+#define VAND(a, b) _mm_and_pd(a, b)
+#define VOR(a, b) _mm_or_pd(a, b)
+#define VXOR(a, b) _mm_xor_pd(a, b)
+#define VSLL(a, n) _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a), n))
+#define VLT(a, b) _mm_cmplt_pd(a, b)
+#define VSELECT(m, a, b) _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b))
+#define VHSUM(a) _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)))
+#include "ctrnnKernelsImpl.h"
+
+// SSE2, single precision
+static inline __attribute__((target("sse2"))) float hsumFloatSse2(__m128 a){
+    __m128 pair = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+#define V __m128
+#define VMASK __m128
+#define VW 4
+#define KERNEL_TARGET __attribute__((target("sse2")))
+#define KERNEL_NAME(name) name##Sse2
+#define VLOAD(p) _mm_loadu_ps(p)
+#define VSTORE(p, a) _mm_storeu_ps(p, a)
+#define VSET1(x) _mm_set1_ps(x)
+#define VADD(a, b) _mm_add_ps(a, b)
+#define VSUB(a, b) _mm_sub_ps(a, b)
+#define VMUL(a, b) _mm_mul_ps(a, b)
+#define VDIV(a, b) _mm_div_ps(a, b)
+#define VMIN(a, b) _mm_min_ps(a, b)
+#define VMAX(a, b) _mm_max_ps(a, b)
+#define VFMA(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define VAND(a, b) _mm_and_ps(a, b)
+#define VOR(a, b) _mm_or_ps(a, b)
+#define VXOR(a, b) _mm_xor_ps(a, b)
+#define VSLL(a, n) _mm_castsi128_ps(_mm_slli_epi32(_mm_castps_si128(a), n))
+#define VLT(a, b) _mm_cmplt_ps(a, b)
+#define VSELECT(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define VHSUM(a) hsumFloatSse2(a)
+#include "ctrnnKernelsFloatImpl.h"
+
+// AVX2 with FMA, double precision
+static inline __attribute__((target("avx2,fma"))) double hsumAvx2(__m256d a){
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+#define V __m256d
+#define VMASK __m256d
+#define VW 4
+#define KERNEL_TARGET __attribute__((target("avx2,fma")))
+#define KERNEL_NAME(name) name##Avx2
+#define VLOAD(p) _mm256_loadu_pd(p)
+#define VSTORE(p, a) _mm256_storeu_pd(p, a)
+#define VSET1(x) _mm256_set1_pd(x)
+#define VADD(a, b) _mm256_add_pd(a, b)
+#define VSUB(a, b) _mm256_sub_pd(a, b)
+#define VMUL(a, b) _mm256_mul_pd(a, b)
+#define VDIV(a, b) _mm256_div_pd(a, b)
+#define VMIN(a, b) _mm256_min_pd(a, b)
+#define VMAX(a, b) _mm256_max_pd(a, b)
+#define VFMA(a, b, c) _mm256_fmadd_pd(a, b, c)
+#define VAND(a, b) _mm256_and_pd(a, b)
+#define VOR(a, b) _mm256_or_pd(a, b)
+#define VXOR(a, b) _mm256_xor_pd(a, b)
+#define VSLL(a, n) _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(a), n))
+#define VLT(a, b) _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define VSELECT(m, a, b) _mm256_blendv_pd(b, a, m)
+#define VHSUM(a) hsumAvx2(a)
+#include "ctrnnKernelsImpl.h"
+
+// AVX2 with FMA, single precision
+static inline __attribute__((target("avx2,fma"))) float hsumFloatAvx2(__m256 a){
+    __m128 quad = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    __m128 pair = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+#define V __m256
+#define VMASK __m256
+#define VW 8
+#define KERNEL_TARGET __attribute__((target("avx2,fma")))
+#define KERNEL_NAME(name) name##Avx2
+#define VLOAD(p) _mm256_loadu_ps(p)
+#define VSTORE(p, a) _mm256_storeu_ps(p, a)
+#define VSET1(x) _mm256_set1_ps(x)
+#define VADD(a, b) _mm256_add_ps(a, b)
+#define VSUB(a, b) _mm256_sub_ps(a, b)
+#define VMUL(a, b) _mm256_mul_ps(a, b)
+#define VDIV(a, b) _mm256_div_ps(a, b)
+#define VMIN(a, b) _mm256_min_ps(a, b)
+#define VMAX(a, b) _mm256_max_ps(a, b)
+#define VFMA(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define VAND(a, b) _mm256_and_ps(a, b)
+#define VOR(a, b) _mm256_or_ps(a, b)
+#define VXOR(a, b) _mm256_xor_ps(a, b)
+#define VSLL(a, n) _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_castps_si256(a), n))
+#define VLT(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define VSELECT(m, a, b) _mm256_blendv_ps(b, a, m)
+#define VHSUM(a) hsumFloatAvx2(a)
+#include "ctrnnKernelsFloatImpl.h"
+
+// AVX-512F, double precision. Bitwise operations on floating point lanes need
+// AVX-512DQ, so they go through the integer forms.
+#define V __m512d
+#define VMASK __mmask8
+#define VW 8
+#define KERNEL_TARGET __attribute__((target("avx512f")))
+#define KERNEL_NAME(name) name##Avx512
+#define VLOAD(p) _mm512_loadu_pd(p)
+#define VSTORE(p, a) _mm512_storeu_pd(p, a)
+#define VSET1(x) _mm512_set1_pd(x)
+#define VADD(a, b) _mm512_add_pd(a, b)
+#define VSUB(a, b) _mm512_sub_pd(a, b)
+#define VMUL(a, b) _mm512_mul_pd(a, b)
+#define VDIV(a, b) _mm512_div_pd(a, b)
+#define VMIN(a, b) _mm512_min_pd(a, b)
+#define VMAX(a, b) _mm512_max_pd(a, b)
+#define VFMA(a, b, c) _mm512_fmadd_pd(a, b, c)
+#define VAND(a, b) _mm512_castsi512_pd(_mm512_and_epi64(_mm512_castpd_si512(a), _mm512_castpd_si512(b)))
+#define VOR(a, b) _mm512_castsi512_pd(_mm512_or_epi64(_mm512_castpd_si512(a), _mm512_castpd_si512(b)))
+#define VXOR(a, b) _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(a), _mm512_castpd_si512(b)))
+#define VSLL(a, n) _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_castpd_si512(a), n))
+#define VLT(a, b) _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ)
+#define VSELECT(m, a, b) _mm512_mask_blend_pd(m, b, a)
+#define VHSUM(a) _mm512_reduce_add_pd(a)
+#include "ctrnnKernelsImpl.h"
+
+// AVX-512F, single precision
+#define V __m512
+#define VMASK __mmask16
+#define VW 16
+#define KERNEL_TARGET __attribute__((target("avx512f")))
+#define KERNEL_NAME(name) name##Avx512
+#define VLOAD(p) _mm512_loadu_ps(p)
+#define VSTORE(p, a) _mm512_storeu_ps(p, a)
+#define VSET1(x) _mm512_set1_ps(x)
+#define VADD(a, b) _mm512_add_ps(a, b)
+#define VSUB(a, b) _mm512_sub_ps(a, b)
+#define VMUL(a, b) _mm512_mul_ps(a, b)
+#define VDIV(a, b) _mm512_div_ps(a, b)
+#define VMIN(a, b) _mm512_min_ps(a, b)
+#define VMAX(a, b) _mm512_max_ps(a, b)
+#define VFMA(a, b, c) _mm512_fmadd_ps(a, b, c)
+#define VAND(a, b) _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a), _mm512_castps_si512(b)))
+#define VOR(a, b) _mm512_castsi512_ps(_mm512_or_epi32(_mm512_castps_si512(a), _mm512_castps_si512(b)))
+#define VXOR(a, b) _mm512_castsi512_ps(_mm512_xor_epi32(_mm512_castps_si512(a), _mm512_castps_si512(b)))
+#define VSLL(a, n) _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_castps_si512(a), n))
+#define VLT(a, b) _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)
+#define VSELECT(m, a, b) _mm512_mask_blend_ps(m, b, a)
+#define VHSUM(a) _mm512_reduce_add_ps(a)
+#include "ctrnnKernelsFloatImpl.h"
+
+static const CTRNNKernels sse2Kernels = {CTRNN_KERNELS_SSE2, matVecSse2, laneMatVecSse2, sineTransferSse2, sineTransferFastSse2, matVecFloatSse2, sineTransferFloatSse2};
+static const CTRNNKernels avx2Kernels = {CTRNN_KERNELS_AVX2, matVecAvx2, laneMatVecAvx2, sineTransferAvx2, sineTransferFastAvx2, matVecFloatAvx2, sineTransferFloatAvx2};
+static const CTRNNKernels avx512Kernels = {CTRNN_KERNELS_AVX512, matVecAvx512, laneMatVecAvx512, sineTransferAvx512, sineTransferFastAvx512, matVecFloatAvx512, sineTransferFloatAvx512};
+
+#endif /* PLECTO_X86_KERNELS */
+
+// Get the sine transfer function of a kernel set for an accuracy mode.
+CTRNNSineTransfer getCTRNNSineTransfer(const CTRNNKernels *kernels, CTRNNTransferMode mode){
+    switch(mode){
+        case CTRNN_TRANSFER_EXACT:
+            return sineTransferScalar;
+        case CTRNN_TRANSFER_FAST:
+            return kernels->sineTransferFast;
+        case CTRNN_TRANSFER_TABLE:
+            initialiseTransferTables();
+            return sineTransferTable;
+        default:
+            return kernels->sineTransfer;
+    }
+}
+// Get the kernels for a level, falling back to the best level the CPU supports below it.
+const CTRNNKernels * getCTRNNKernels(CTRNNKernelLevel level){
+    // Networks are rarely wide enough to fill 8 lanes, so AVX-512 is opt-in.
+    if(level == CTRNN_KERNELS_AUTO){
+        level = CTRNN_KERNELS_AVX2;
+    }
+#ifdef PLECTO_X86_KERNELS
+    __builtin_cpu_init();
+    if(level >= CTRNN_KERNELS_AVX512 && __builtin_cpu_supports("avx512f")){
+        return &avx512Kernels;
+    }
+    if(level >= CTRNN_KERNELS_AVX2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        return &avx2Kernels;
+    }
+    if(level >= CTRNN_KERNELS_SSE2 && __builtin_cpu_supports("sse2")){
+        return &sse2Kernels;
+    }
+#endif
+    return &scalarKernels;
+}
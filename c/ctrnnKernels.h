@@ -0,0 +1,55 @@
+#ifndef ctrnnKernels_h
+#define ctrnnKernels_h
+
+#ifdef __cplusplus 
+extern "C" { 
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Instruction set used by the step kernels. Levels are ordered by capability.
+typedef enum CTRNNKernelLevel {
+    CTRNN_KERNELS_AUTO = 0, // Best level up to AVX2 supported by the running CPU.
+    CTRNN_KERNELS_SCALAR, // Plain C with libm. Gives the same results on every CPU.
+    CTRNN_KERNELS_SSE2,
+    CTRNN_KERNELS_AVX2, // AVX2 with FMA.
+    CTRNN_KERNELS_AVX512 // AVX-512F. Only faster for networks of 64+ hidden nodes.
+} CTRNNKernelLevel;
+
+// Accuracy of the sine transfer function stage.
+typedef enum CTRNNTransferMode {
+    CTRNN_TRANSFER_ACCURATE = 0, // Vectorised approximations within a couple of ulps of libm. libm for scalar kernels.
+    CTRNN_TRANSFER_EXACT, // libm tanh and sin, one node at a time.
+    CTRNN_TRANSFER_FAST, // Pade tanh and short polynomial sin. Max error 9.7e-5.
+    CTRNN_TRANSFER_TABLE // Interpolated lookup tables. Max error 1.5e-6. Scalar only, suits targets without SIMD.
+} CTRNNTransferMode;
+
+// out[i] = tanhCoefficient[i] * tanh(activation[i]) + sineCoefficient[i] * sin(frequencyMultiplier[i] * activation[i]),
+// where tanhCoefficient is the precomputed 1 - sineCoefficient. out may alias activation.
+typedef void (*CTRNNSineTransfer)(const double *activation, const double *tanhCoefficient, const double *sineCoefficient, const double *frequencyMultiplier, double *out, int n);
+
+// Kernels that step every node of a network at once.
+typedef struct CTRNNKernels {
+    CTRNNKernelLevel level;
+    // Accumulate weights (row-major, numRows x numCols) times state into sums.
+    void (*matVec)(const double *weights, const double *state, double *sums, int numRows, int numCols);
+    // Same as matVec for numLanes interleaved networks. weights is laid out [row][col][lane],
+    // state [col][lane] and sums [row][lane].
+    void (*laneMatVec)(const double *weights, const double *state, double *sums, int numRows, int numCols, int numLanes);
+    CTRNNSineTransfer sineTransfer;
+    CTRNNSineTransfer sineTransferFast;
+    // Single-precision versions of matVec and sineTransfer for CTRNNf.
+    void (*matVecFloat)(const float *weights, const float *state, float *sums, int numRows, int numCols);
+    void (*sineTransferFloat)(const float *activation, const float *tanhCoefficient, const float *sineCoefficient, const float *frequencyMultiplier, float *out, int n);
+} CTRNNKernels;
+
+const CTRNNKernels * getCTRNNKernels(CTRNNKernelLevel level);
+
+CTRNNSineTransfer getCTRNNSineTransfer(const CTRNNKernels *kernels, CTRNNTransferMode mode);
+
+#ifdef __cplusplus 
+}
+#endif
+
+#endif /* ctrnnKernels_h */
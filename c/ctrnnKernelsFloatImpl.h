@@ -0,0 +1,122 @@
+// Single-precision body of the SIMD step kernels. Uses the same vector
+// operations as ctrnnKernelsImpl.h, defined for float lanes, and undefines
+// them again at the end of the file.
+
+// expf(x) for 0 <= x <= 18 (Cephes polynomial).
+static inline KERNEL_TARGET V KERNEL_NAME(vecExpFloat)(V x){
+    V t = VFMA(x, VSET1(1.44269502f), VSET1(12582912.0f)); // 1.5 * 2^23 rounds to an integer.
+    V n = VSUB(t, VSET1(12582912.0f));
+    V r = VSUB(VSUB(x, VMUL(n, VSET1(0.693359375f))), VMUL(n, VSET1(-2.12194440e-4f)));
+    V p = VSET1(1.9875691500E-4f);
+    p = VFMA(p, r, VSET1(1.3981999507E-3f));
+    p = VFMA(p, r, VSET1(8.3334519073E-3f));
+    p = VFMA(p, r, VSET1(4.1665795894E-2f));
+    p = VFMA(p, r, VSET1(1.6666665459E-1f));
+    p = VFMA(p, r, VSET1(5.0000001201E-1f));
+    V e = VADD(VFMA(VMUL(p, r), r, r), VSET1(1.0f));
+    // 2^n from the exponent bits of n + 127.
+    V scale = VSLL(VADD(n, VSET1(8388735.0f)), 23); // 2^23 + 127.
+    return VMUL(e, scale);
+}
+// tanhf(x). Polynomial below 0.625, 1 - 2 / (exp(2|x|) + 1) above.
+static inline KERNEL_TARGET V KERNEL_NAME(vecTanhFloat)(V x){
+    V sign = VAND(x, VSET1(-0.0f));
+    V ax = VXOR(x, sign);
+    V z = VMUL(x, x);
+    V p = VSET1(-5.70498872745E-3f);
+    p = VFMA(p, z, VSET1(2.06390887954E-2f));
+    p = VFMA(p, z, VSET1(-5.37397155531E-2f));
+    p = VFMA(p, z, VSET1(1.33314422036E-1f));
+    p = VFMA(p, z, VSET1(-3.33332819422E-1f));
+    V small = VFMA(VMUL(x, z), p, x);
+    // tanhf rounds to 1 well before 9.
+    V e = KERNEL_NAME(vecExpFloat)(VMUL(VSET1(2.0f), VMIN(ax, VSET1(9.0f))));
+    V large = VOR(VSUB(VSET1(1.0f), VDIV(VSET1(2.0f), VADD(e, VSET1(1.0f)))), sign);
+    return VSELECT(VLT(ax, VSET1(0.625f)), small, large);
+}
+// sinf(x). Reduces by the nearest multiple of pi, then evaluates a degree 13
+// odd polynomial on [-pi/2, pi/2]. Accurate for |x| < 25000.
+static inline KERNEL_TARGET V KERNEL_NAME(vecSinFloat)(V x){
+    V t = VFMA(x, VSET1(0.318309873f), VSET1(12582912.0f));
+    V n = VSUB(t, VSET1(12582912.0f));
+    V r = VSUB(VSUB(VSUB(x, VMUL(n, VSET1(3.140625f))), VMUL(n, VSET1(9.67502593994140625E-4f))), VMUL(n, VSET1(1.509957990978376432E-7f)));
+    // The low bit of t is the parity of n. Odd multiples of pi flip the sign.
+    V flip = VSLL(t, 31);
+    V rr = VMUL(r, r);
+    V s = VSET1(1.60590444e-10f);
+    s = VFMA(s, rr, VSET1(-2.50521079e-08f));
+    s = VFMA(s, rr, VSET1(2.75573188e-06f));
+    s = VFMA(s, rr, VSET1(-0.000198412701f));
+    s = VFMA(s, rr, VSET1(0.00833333377f));
+    s = VFMA(s, rr, VSET1(-0.166666672f));
+    s = VFMA(VMUL(r, rr), s, r);
+    return VXOR(s, flip);
+}
+static inline KERNEL_TARGET V KERNEL_NAME(vecSineTransferFloat)(V a, V tanhCoefficient, V sineCoefficient, V frequencyMultiplier){
+    V tanhPart = VMUL(tanhCoefficient, KERNEL_NAME(vecTanhFloat)(a));
+    return VFMA(sineCoefficient, KERNEL_NAME(vecSinFloat)(VMUL(frequencyMultiplier, a)), tanhPart);
+}
+static KERNEL_TARGET void KERNEL_NAME(sineTransferFloat)(const float *activation, const float *tanhCoefficient, const float *sineCoefficient, const float *frequencyMultiplier, float *out, int n){
+    int i;
+    for(i = 0; i + VW <= n; i += VW){
+        VSTORE(out + i, KERNEL_NAME(vecSineTransferFloat)(VLOAD(activation + i), VLOAD(tanhCoefficient + i), VLOAD(sineCoefficient + i), VLOAD(frequencyMultiplier + i)));
+    }
+    // Remainder goes through a zero padded vector so every node sees the same approximation.
+    if(i < n){
+        float a[VW] = {0};
+        float c[VW] = {0};
+        float s[VW] = {0};
+        float f[VW] = {0};
+        float o[VW];
+        int lane;
+        for(lane = 0; i + lane < n; lane++){
+            a[lane] = activation[i + lane];
+            c[lane] = tanhCoefficient[i + lane];
+            s[lane] = sineCoefficient[i + lane];
+            f[lane] = frequencyMultiplier[i + lane];
+        }
+        VSTORE(o, KERNEL_NAME(vecSineTransferFloat)(VLOAD(a), VLOAD(c), VLOAD(s), VLOAD(f)));
+        for(lane = 0; i + lane < n; lane++){
+            out[i + lane] = o[lane];
+        }
+    }
+}
+static KERNEL_TARGET void KERNEL_NAME(matVecFloat)(const float *weights, const float *state, float *sums, int numRows, int numCols){
+    int r;
+    int c;
+    for(r = 0; r < numRows; r++){
+        const float *row = weights + (size_t)r * numCols;
+        V acc = VSET1(0.0f);
+        for(c = 0; c + VW <= numCols; c += VW){
+            acc = VFMA(VLOAD(row + c), VLOAD(state + c), acc);
+        }
+        float sum = VHSUM(acc);
+        for(; c < numCols; c++){
+            sum += row[c] * state[c];
+        }
+        sums[r] += sum;
+    }
+}
+
+#undef V
+#undef VMASK
+#undef VW
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#undef VMIN
+#undef VMAX
+#undef VFMA
+#undef VAND
+#undef VOR
+#undef VXOR
+#undef VSLL
+#undef VLT
+#undef VSELECT
+#undef VHSUM
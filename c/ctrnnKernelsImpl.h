@@ -0,0 +1,181 @@
+// Body of the SIMD step kernels. ctrnnKernels.c includes this file once per
+// instruction set after defining the vector operations below, so every
+// kernel is written once:
+//
+//  V, VMASK, VW          vector type, comparison mask type, lanes per vector
+//  KERNEL_TARGET         function attribute enabling the instruction set
+//  KERNEL_NAME(name)     suffixes name with the instruction set
+//  VLOAD, VSTORE, VSET1  unaligned load/store, broadcast
+//  VADD, VSUB, VMUL, VDIV, VMIN, VMAX, VFMA(a, b, c) = a * b + c
+//  VAND, VOR, VXOR       bitwise operations on the lanes
+//  VSLL(a, n)            shift the bit pattern of each lane left by n
+//  VLT(a, b)             mask of a < b, VSELECT(m, a, b) picks a where m is set
+//  VHSUM(a)              sum of all lanes
+//
+// The operations are undefined again at the end of the file.
+
+// exp(x) for 0 <= x <= 44 (Cephes rational approximation).
+static inline KERNEL_TARGET V KERNEL_NAME(vecExp)(V x){
+    V t = VFMA(x, VSET1(KERNEL_LOG2E), VSET1(KERNEL_ROUND_MAGIC));
+    V n = VSUB(t, VSET1(KERNEL_ROUND_MAGIC));
+    V r = VSUB(VSUB(x, VMUL(n, VSET1(KERNEL_EXP_C1))), VMUL(n, VSET1(KERNEL_EXP_C2)));
+    V rr = VMUL(r, r);
+    V p = VMUL(r, VFMA(VFMA(VSET1(KERNEL_EXP_P0), rr, VSET1(KERNEL_EXP_P1)), rr, VSET1(KERNEL_EXP_P2)));
+    V q = VFMA(VFMA(VFMA(VSET1(KERNEL_EXP_Q0), rr, VSET1(KERNEL_EXP_Q1)), rr, VSET1(KERNEL_EXP_Q2)), rr, VSET1(KERNEL_EXP_Q3));
+    V e = VFMA(VSET1(2.0), VDIV(p, VSUB(q, p)), VSET1(1.0));
+    // 2^n from the exponent bits of n + 1023.
+    V scale = VSLL(VADD(n, VSET1(KERNEL_EXP_BIAS_MAGIC)), 52);
+    return VMUL(e, scale);
+}
+// tanh(x). Rational approximation below 0.625, 1 - 2 / (exp(2|x|) + 1) above.
+static inline KERNEL_TARGET V KERNEL_NAME(vecTanh)(V x){
+    V sign = VAND(x, VSET1(KERNEL_SIGN_MASK));
+    V ax = VXOR(x, sign);
+    V z = VMUL(x, x);
+    V p = VFMA(VFMA(VSET1(KERNEL_TANH_P0), z, VSET1(KERNEL_TANH_P1)), z, VSET1(KERNEL_TANH_P2));
+    V q = VFMA(VFMA(VADD(z, VSET1(KERNEL_TANH_Q0)), z, VSET1(KERNEL_TANH_Q1)), z, VSET1(KERNEL_TANH_Q2));
+    V small = VFMA(VMUL(x, z), VDIV(p, q), x);
+    // tanh rounds to 1 well before 22.
+    V e = KERNEL_NAME(vecExp)(VMUL(VSET1(2.0), VMIN(ax, VSET1(22.0))));
+    V large = VOR(VSUB(VSET1(1.0), VDIV(VSET1(2.0), VADD(e, VSET1(1.0)))), sign);
+    return VSELECT(VLT(ax, VSET1(0.625)), small, large);
+}
+// sin(x). Reduces by the nearest multiple of pi, then evaluates a degree 23
+// odd polynomial on [-pi/2, pi/2]. Accurate for |x| < 2^30.
+static inline KERNEL_TARGET V KERNEL_NAME(vecSin)(V x){
+    V t = VFMA(x, VSET1(KERNEL_INV_PI), VSET1(KERNEL_ROUND_MAGIC));
+    V n = VSUB(t, VSET1(KERNEL_ROUND_MAGIC));
+    V r = VSUB(VSUB(VSUB(x, VMUL(n, VSET1(KERNEL_PI_1))), VMUL(n, VSET1(KERNEL_PI_2))), VMUL(n, VSET1(KERNEL_PI_3)));
+    // The low bit of t is the parity of n. Odd multiples of pi flip the sign.
+    V flip = VSLL(t, 63);
+    V rr = VMUL(r, r);
+    V s = VSET1(KERNEL_SIN_S11);
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S10));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S9));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S8));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S7));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S6));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S5));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S4));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S3));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S2));
+    s = VFMA(s, rr, VSET1(KERNEL_SIN_S1));
+    s = VFMA(VMUL(r, rr), s, r);
+    return VXOR(s, flip);
+}
+static inline KERNEL_TARGET V KERNEL_NAME(vecSineTransfer)(V a, V tanhCoefficient, V sineCoefficient, V frequencyMultiplier){
+    V tanhPart = VMUL(tanhCoefficient, KERNEL_NAME(vecTanh)(a));
+    return VFMA(sineCoefficient, KERNEL_NAME(vecSin)(VMUL(frequencyMultiplier, a)), tanhPart);
+}
+static KERNEL_TARGET void KERNEL_NAME(sineTransfer)(const double *activation, const double *tanhCoefficient, const double *sineCoefficient, const double *frequencyMultiplier, double *out, int n){
+    int i;
+    for(i = 0; i + VW <= n; i += VW){
+        VSTORE(out + i, KERNEL_NAME(vecSineTransfer)(VLOAD(activation + i), VLOAD(tanhCoefficient + i), VLOAD(sineCoefficient + i), VLOAD(frequencyMultiplier + i)));
+    }
+    // Remainder goes through a zero padded vector so every node sees the same approximation.
+    if(i < n){
+        double a[VW] = {0};
+        double c[VW] = {0};
+        double s[VW] = {0};
+        double f[VW] = {0};
+        double o[VW];
+        int lane;
+        for(lane = 0; i + lane < n; lane++){
+            a[lane] = activation[i + lane];
+            c[lane] = tanhCoefficient[i + lane];
+            s[lane] = sineCoefficient[i + lane];
+            f[lane] = frequencyMultiplier[i + lane];
+        }
+        VSTORE(o, KERNEL_NAME(vecSineTransfer)(VLOAD(a), VLOAD(c), VLOAD(s), VLOAD(f)));
+        for(lane = 0; i + lane < n; lane++){
+            out[i + lane] = o[lane];
+        }
+    }
+}
+// CTRNN_TRANSFER_FAST approximations, matching fastSineTransferFunction.
+static inline KERNEL_TARGET V KERNEL_NAME(vecSineTransferFast)(V a, V tanhCoefficient, V sineCoefficient, V frequencyMultiplier){
+    V x = VMAX(VMIN(a, VSET1(5.0)), VSET1(-5.0));
+    V xx = VMUL(x, x);
+    V num = VMUL(x, VFMA(VFMA(VADD(xx, VSET1(KERNEL_PADE_N2)), xx, VSET1(KERNEL_PADE_N1)), xx, VSET1(KERNEL_PADE_N0)));
+    V den = VFMA(VFMA(VFMA(xx, VSET1(KERNEL_PADE_D3), VSET1(KERNEL_PADE_D2)), xx, VSET1(KERNEL_PADE_D1)), xx, VSET1(KERNEL_PADE_N0));
+    V tanhValue = VMAX(VMIN(VDIV(num, den), VSET1(1.0)), VSET1(-1.0));
+    V f = VMUL(frequencyMultiplier, a);
+    V t = VFMA(f, VSET1(KERNEL_INV_PI), VSET1(KERNEL_ROUND_MAGIC));
+    V n = VSUB(t, VSET1(KERNEL_ROUND_MAGIC));
+    V r = VSUB(VSUB(f, VMUL(n, VSET1(KERNEL_PI_1))), VMUL(n, VSET1(KERNEL_PI_2)));
+    V rr = VMUL(r, r);
+    V s = VFMA(VFMA(VFMA(VSET1(KERNEL_SIN_S4), rr, VSET1(KERNEL_SIN_S3)), rr, VSET1(KERNEL_SIN_S2)), rr, VSET1(KERNEL_SIN_S1));
+    s = VXOR(VFMA(VMUL(r, rr), s, r), VSLL(t, 63));
+    return VFMA(sineCoefficient, s, VMUL(tanhCoefficient, tanhValue));
+}
+static KERNEL_TARGET void KERNEL_NAME(sineTransferFast)(const double *activation, const double *tanhCoefficient, const double *sineCoefficient, const double *frequencyMultiplier, double *out, int n){
+    int i;
+    for(i = 0; i + VW <= n; i += VW){
+        VSTORE(out + i, KERNEL_NAME(vecSineTransferFast)(VLOAD(activation + i), VLOAD(tanhCoefficient + i), VLOAD(sineCoefficient + i), VLOAD(frequencyMultiplier + i)));
+    }
+    for(; i < n; i++){
+        out[i] = tanhCoefficient[i] * fastTanh(activation[i]) + sineCoefficient[i] * fastSin(frequencyMultiplier[i] * activation[i]);
+    }
+}
+static KERNEL_TARGET void KERNEL_NAME(matVec)(const double *weights, const double *state, double *sums, int numRows, int numCols){
+    int r;
+    int c;
+    for(r = 0; r < numRows; r++){
+        const double *row = weights + (size_t)r * numCols;
+        V acc = VSET1(0.0);
+        for(c = 0; c + VW <= numCols; c += VW){
+            acc = VFMA(VLOAD(row + c), VLOAD(state + c), acc);
+        }
+        double sum = VHSUM(acc);
+        for(; c < numCols; c++){
+            sum += row[c] * state[c];
+        }
+        sums[r] += sum;
+    }
+}
+
+static KERNEL_TARGET void KERNEL_NAME(laneMatVec)(const double *weights, const double *state, double *sums, int numRows, int numCols, int numLanes){
+    int r;
+    int c;
+    int lane;
+    for(r = 0; r < numRows; r++){
+        const double *row = weights + (size_t)r * numCols * numLanes;
+        double *rowSums = sums + (size_t)r * numLanes;
+        // Keep a vector of lanes in a register across the whole row.
+        for(lane = 0; lane + VW <= numLanes; lane += VW){
+            V acc = VLOAD(rowSums + lane);
+            for(c = 0; c < numCols; c++){
+                acc = VFMA(VLOAD(row + (size_t)c * numLanes + lane), VLOAD(state + (size_t)c * numLanes + lane), acc);
+            }
+            VSTORE(rowSums + lane, acc);
+        }
+        for(; lane < numLanes; lane++){
+            for(c = 0; c < numCols; c++){
+                rowSums[lane] += row[(size_t)c * numLanes + lane] * state[(size_t)c * numLanes + lane];
+            }
+        }
+    }
+}
+
+#undef V
+#undef VMASK
+#undef VW
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+#undef VLOAD
+#undef VSTORE
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VMUL
+#undef VDIV
+#undef VMIN
+#undef VMAX
+#undef VFMA
+#undef VAND
+#undef VOR
+#undef VXOR
+#undef VSLL
+#undef VLT
+#undef VSELECT
+#undef VHSUM
@@ -0,0 +1,178 @@
+#include "ctrnnSwap.h"
+
+// Build a network for the swap. Control thread only.
+static CTRNNSwapNetwork *buildSwapNetwork(CTRNNSwap *swap, ConfigDesc *configDesc, CTRNNSwapTransition transition, int fadeSteps){
+    CTRNNSwapNetwork *network = (CTRNNSwapNetwork *)calloc(1, sizeof(CTRNNSwapNetwork));
+    initialiseCTRNN(&network->ctrnn, configDesc, swap->timeStep);
+    selectCTRNNKernels(&network->ctrnn, swap->kernelLevel);
+    selectCTRNNTransferMode(&network->ctrnn, swap->transferMode);
+    selectCTRNNIntegrator(&network->ctrnn, swap->integrator);
+    setCTRNNFreeze(&network->ctrnn, swap->freezeThreshold, swap->freezeSteps);
+    network->transition = transition;
+    network->fadeSteps = fadeSteps;
+    return network;
+}
+// Free a network that no thread can reach any more.
+static void freeSwapNetwork(CTRNNSwapNetwork *network){
+    if(network){
+        destroyCTRNN(&network->ctrnn);
+        free(network);
+    }
+}
+// Copy node states from one network into another. Input nodes and hidden nodes are matched by index.
+static void carrySwapState(CTRNN *from, CTRNN *to){
+    int numInputNodes = from->numInputNodes < to->numInputNodes ? from->numInputNodes : to->numInputNodes;
+    int numHiddenNodes = from->numHiddenNodes < to->numHiddenNodes ? from->numHiddenNodes : to->numHiddenNodes;
+    int node;
+    for(node = 0; node < numInputNodes; node++){
+        to->inputs[node] = from->inputs[node];
+        to->y[node] = from->y[node];
+        to->output[node] = from->output[node];
+    }
+    for(node = 0; node < numHiddenNodes; node++){
+        to->y[to->numInputNodes + node] = from->y[from->numInputNodes + node];
+        to->output[to->numInputNodes + node] = from->output[from->numInputNodes + node];
+    }
+}
+// Output of a hidden node, blended between the fading and active networks during a crossfade.
+static double swapOutput(CTRNNSwap *swap, int node){
+    CTRNN *active = &swap->active->ctrnn;
+    double output = active->output[active->numInputNodes + node];
+    if(swap->fading && node < swap->fading->ctrnn.numHiddenNodes){
+        CTRNN *fading = &swap->fading->ctrnn;
+        double mix = (double)swap->fadePosition / swap->active->fadeSteps;
+        output = fading->output[fading->numInputNodes + node] + mix * (output - fading->output[fading->numInputNodes + node]);
+    }
+    return output;
+}
+// Initialise the swap with the network that plays until the first swap. Call before the audio thread starts.
+void initialiseCTRNNSwap(CTRNNSwap *swap, ConfigDesc *configDesc, double timeStep){
+    if(swap->initialised){
+        destroyCTRNNSwap(swap);
+    }
+    swap->timeStep = timeStep;
+    swap->kernelLevel = CTRNN_KERNELS_AUTO;
+    swap->transferMode = CTRNN_TRANSFER_ACCURATE;
+    swap->integrator = CTRNN_INTEGRATE_EULER;
+    swap->freezeThreshold = 0;
+    swap->freezeSteps = 0;
+    swap->pending = NULL;
+    swap->retired = NULL;
+    swap->fading = NULL;
+    swap->fadePosition = 0;
+    swap->active = buildSwapNetwork(swap, configDesc, CTRNN_SWAP_RESET, 0);
+    swap->initialised = 1;
+}
+// Build a network from configDesc and publish it to the audio thread. Control thread only.
+// A network published earlier that the audio thread has not picked up yet is replaced.
+void requestCTRNNSwap(CTRNNSwap *swap, ConfigDesc *configDesc, CTRNNSwapTransition transition, int fadeSteps){
+    collectCTRNNSwap(swap);
+    CTRNNSwapNetwork *network = buildSwapNetwork(swap, configDesc, transition, fadeSteps);
+    freeSwapNetwork(__atomic_exchange_n(&swap->pending, network, __ATOMIC_ACQ_REL));
+}
+// Free the network the audio thread last retired. Control thread only. Call regularly, the
+// audio thread holds back the next swap until the previous network has been collected.
+void collectCTRNNSwap(CTRNNSwap *swap){
+    freeSwapNetwork(__atomic_exchange_n(&swap->retired, NULL, __ATOMIC_ACQ_REL));
+}
+// Select the instruction set of networks built from now on. Control thread only.
+void selectCTRNNSwapKernels(CTRNNSwap *swap, CTRNNKernelLevel level){
+    swap->kernelLevel = level;
+}
+// Select the transfer function accuracy of networks built from now on. Control thread only.
+void selectCTRNNSwapTransferMode(CTRNNSwap *swap, CTRNNTransferMode mode){
+    swap->transferMode = mode;
+}
+// Select how networks built from now on are integrated. Control thread only.
+void selectCTRNNSwapIntegrator(CTRNNSwap *swap, CTRNNIntegrator integrator){
+    swap->integrator = integrator;
+}
+// Set how networks built from now on freeze on a fixed point, see setCTRNNFreeze. Control thread only.
+void setCTRNNSwapFreeze(CTRNNSwap *swap, double threshold, int steps){
+    swap->freezeThreshold = threshold;
+    swap->freezeSteps = steps;
+}
+// Pick up a pending network at a block boundary. Audio thread only, never locks or allocates.
+void beginCTRNNSwapBlock(CTRNNSwap *swap){
+    // Wait while a crossfade is running or the last retired network has not been collected.
+    if(swap->fading || __atomic_load_n(&swap->pending, __ATOMIC_RELAXED) == NULL || __atomic_load_n(&swap->retired, __ATOMIC_ACQUIRE) != NULL){
+        return;
+    }
+    CTRNNSwapNetwork *network = __atomic_exchange_n(&swap->pending, NULL, __ATOMIC_ACQ_REL);
+    if(network == NULL){
+        return;
+    }
+    CTRNNSwapNetwork *previous = swap->active;
+    swap->active = network;
+    if(network->transition == CTRNN_SWAP_CROSSFADE && network->fadeSteps > 0){
+        swap->fading = previous;
+        swap->fadePosition = 0;
+        return;
+    }
+    if(network->transition == CTRNN_SWAP_CARRY_STATE){
+        carrySwapState(&previous->ctrnn, &network->ctrnn);
+    }
+    __atomic_store_n(&swap->retired, previous, __ATOMIC_RELEASE);
+}
+// Feed inputs, sized for the active network, to it and to the network being faded out.
+void feedCTRNNSwapInputs(CTRNNSwap *swap, double inputs[]){
+    feedCTRNNInputs(&swap->active->ctrnn, inputs);
+    if(swap->fading){
+        CTRNN *fading = &swap->fading->ctrnn;
+        int iNode;
+        for(iNode = 0; iNode < fading->numInputNodes && iNode < swap->active->ctrnn.numInputNodes; iNode++){
+            fading->inputs[iNode] = inputs[iNode];
+        }
+    }
+}
+// Step the active network, and the fading one until its crossfade completes.
+void updateCTRNNSwap(CTRNNSwap *swap){
+    stepCTRNN(&swap->active->ctrnn);
+    if(swap->fading){
+        stepCTRNN(&swap->fading->ctrnn);
+        swap->fadePosition++;
+        // The retired slot was empty when the crossfade started and only this thread fills it.
+        if(swap->fadePosition >= swap->active->fadeSteps){
+            __atomic_store_n(&swap->retired, swap->fading, __ATOMIC_RELEASE);
+            swap->fading = NULL;
+        }
+    }
+}
+// Get the outputs, blended during a crossfade.
+void getCTRNNSwapOutput(CTRNNSwap *swap, double * outputs, int numOutputNodes){
+    int i;
+    for(i = 0; i < numOutputNodes; i++){
+        outputs[i] = swapOutput(swap, i);
+    }
+}
+// Render numSteps steps in one call, picking up any pending network first. See renderCTRNNBlock.
+void renderCTRNNSwapBlock(CTRNNSwap *swap, const double *inputs, int inputStride, double *outputs, int numOutputNodes, CTRNNOutputLayout layout, int numSteps){
+    int step;
+    int i;
+    beginCTRNNSwapBlock(swap);
+    for(step = 0; step < numSteps; step++){
+        if(inputs){
+            feedCTRNNSwapInputs(swap, (double *)(inputs + (size_t)step * inputStride));
+        }
+        updateCTRNNSwap(swap);
+        if(layout == CTRNN_OUTPUT_PLANAR){
+            for(i = 0; i < numOutputNodes; i++){
+                outputs[(size_t)i * numSteps + step] = swapOutput(swap, i);
+            }
+        } else {
+            getCTRNNSwapOutput(swap, outputs + (size_t)step * numOutputNodes, numOutputNodes);
+        }
+    }
+}
+// Free every network held by the swap. Call once the audio thread has stopped.
+void destroyCTRNNSwap(CTRNNSwap *swap){
+    freeSwapNetwork(swap->pending);
+    freeSwapNetwork(swap->retired);
+    freeSwapNetwork(swap->active);
+    freeSwapNetwork(swap->fading);
+    swap->pending = NULL;
+    swap->retired = NULL;
+    swap->active = NULL;
+    swap->fading = NULL;
+    swap->initialised = 0;
+}
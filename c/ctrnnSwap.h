@@ -0,0 +1,79 @@
+#ifndef ctrnnSwap_h
+#define ctrnnSwap_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctrnn.h"
+
+// How the audio thread moves from the playing network to a newly swapped in one.
+typedef enum CTRNNSwapTransition {
+    CTRNN_SWAP_RESET = 0, // The new network starts from its initial state.
+    CTRNN_SWAP_CARRY_STATE, // The new network continues from the node states of the old one.
+    CTRNN_SWAP_CROSSFADE // Both networks run while the outputs fade linearly from the old to the new one.
+} CTRNNSwapTransition;
+
+// A network built off the audio thread, with the transition to use when it is picked up.
+typedef struct CTRNNSwapNetwork {
+
+    CTRNN ctrnn;
+    CTRNNSwapTransition transition;
+    int fadeSteps;
+
+} CTRNNSwapNetwork;
+
+// Double-buffered CTRNN for switching presets while audio is running. The control
+// thread builds networks and publishes them to pending. The audio thread picks them
+// up with one atomic exchange at a block boundary and hands the old network back
+// through retired, so it never locks, allocates or frees.
+typedef struct CTRNNSwap {
+
+    CTRNNSwapNetwork *pending; // Published by the control thread, taken by the audio thread.
+    CTRNNSwapNetwork *retired; // Released by the audio thread, freed by the control thread.
+    CTRNNSwapNetwork *active; // Audio thread only.
+    CTRNNSwapNetwork *fading; // Audio thread only. Network being faded out.
+    int fadePosition; // Audio thread only. Steps of the crossfade done so far.
+    double timeStep; // Control thread only. Applied to every network built.
+    CTRNNKernelLevel kernelLevel; // Control thread only.
+    CTRNNTransferMode transferMode; // Control thread only.
+    CTRNNIntegrator integrator; // Control thread only.
+    double freezeThreshold; // Control thread only.
+    int freezeSteps; // Control thread only.
+    int initialised;
+
+} CTRNNSwap;
+
+void initialiseCTRNNSwap(CTRNNSwap *swap, ConfigDesc *configDesc, double timeStep);
+
+void requestCTRNNSwap(CTRNNSwap *swap, ConfigDesc *configDesc, CTRNNSwapTransition transition, int fadeSteps);
+
+void collectCTRNNSwap(CTRNNSwap *swap);
+
+void selectCTRNNSwapKernels(CTRNNSwap *swap, CTRNNKernelLevel level);
+
+void selectCTRNNSwapTransferMode(CTRNNSwap *swap, CTRNNTransferMode mode);
+
+void selectCTRNNSwapIntegrator(CTRNNSwap *swap, CTRNNIntegrator integrator);
+
+void setCTRNNSwapFreeze(CTRNNSwap *swap, double threshold, int steps);
+
+void beginCTRNNSwapBlock(CTRNNSwap *swap);
+
+void feedCTRNNSwapInputs(CTRNNSwap *swap, double inputs[]);
+
+void updateCTRNNSwap(CTRNNSwap *swap);
+
+void getCTRNNSwapOutput(CTRNNSwap *swap, double * outputs, int numOutputNodes);
+
+void renderCTRNNSwapBlock(CTRNNSwap *swap, const double *inputs, int inputStride, double *outputs, int numOutputNodes, CTRNNOutputLayout layout, int numSteps);
+
+void destroyCTRNNSwap(CTRNNSwap *swap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ctrnnSwap_h */
@@ -0,0 +1,203 @@
+#include <stdint.h>
+#include "ctrnnf.h"
+
+// Map the parameters of a config node into a node slot of the CTRNN.
+static void mapNodeParamsf(CTRNNf *ctrnn, int node, ConfigNode *configNode){
+    ctrnn->gain[node] = (float)mapGain(configNode->gain);
+    ctrnn->gainBias[node] = ctrnn->gain[node] * (float)mapBias(configNode->bias);
+    ctrnn->t[node] = (float)mapTimeConstant(configNode->t);
+    ctrnn->rate[node] = ctrnn->timeStep / ctrnn->t[node];
+    ctrnn->sineCoefficient[node] = (float)mapSineCoefficient(configNode->sineCoefficient);
+    ctrnn->tanhCoefficient[node] = 1.0f - ctrnn->sineCoefficient[node];
+    ctrnn->frequencyMultiplier[node] = (float)mapFrequencyMultiplier(configNode->frequencyMultiplier);
+}
+// Per-node vectors in the CTRNNf block: y, output, tempOutput, gain, gainBias, t, rate,
+// sineCoefficient, tanhCoefficient and frequencyMultiplier.
+#define NODE_VECTORS 10
+// Every vector in the block starts on its own cache line.
+#define VECTOR_ALIGNMENT 64
+
+// Bytes taken by a vector of count values, rounded up to whole cache lines.
+static size_t vectorBytes(size_t count){
+    size_t bytes = sizeof(float) * count;
+    return (bytes + VECTOR_ALIGNMENT - 1) / VECTOR_ALIGNMENT * VECTOR_ALIGNMENT;
+}
+// Take the next vector of count values from the block.
+static float *carveVector(char **cursor, size_t count){
+    float *vector = (float *)*cursor;
+    *cursor += vectorBytes(count);
+    return vector;
+}
+// Bytes of storage a CTRNNf built from configDesc needs, including slack to align the block.
+size_t ctrnnfRequiredBytes(ConfigDesc *configDesc){
+    size_t numInputNodes = configDesc->numInputNodes;
+    size_t numNodes = numInputNodes + configDesc->numHiddenNodes;
+    return VECTOR_ALIGNMENT - 1
+        + vectorBytes(configDesc->numHiddenNodes * numNodes)
+        + 3 * vectorBytes(numInputNodes)
+        + NODE_VECTORS * vectorBytes(numNodes);
+}
+// Destroy an initialised CTRNNf, keeping its kernel and freeze selections.
+static void prepareCTRNNf(CTRNNf *ctrnn){
+    if(ctrnn->initialised){
+        destroyCTRNNf(ctrnn);
+    } else {
+        ctrnn->kernels = getCTRNNKernels(CTRNN_KERNELS_AUTO);
+        ctrnn->freezeThreshold = 0;
+        ctrnn->freezeSteps = 0;
+    }
+}
+// Lay the CTRNNf out in memory, which must hold ctrnnfRequiredBytes(configDesc) bytes, and map configDesc into it.
+static void layoutCTRNNf(CTRNNf *ctrnn, ConfigDesc *configDesc, float timeStep, void *memory){
+    ctrnn->numInputNodes = configDesc->numInputNodes;
+    ctrnn->numHiddenNodes = configDesc->numHiddenNodes;
+    ctrnn->numNodes = configDesc->numInputNodes + configDesc->numHiddenNodes;
+    ctrnn->timeStep = timeStep;
+    // Num output nodes is defined in code and cannot exceed hidden nodes.
+    int numNodes = ctrnn->numNodes;
+    // Carve every vector out of the block.
+    char *cursor = (char *)(((uintptr_t)memory + VECTOR_ALIGNMENT - 1) & ~(uintptr_t)(VECTOR_ALIGNMENT - 1));
+    ctrnn->memory = memory;
+    ctrnn->weights = carveVector(&cursor, (size_t)ctrnn->numHiddenNodes * numNodes);
+    ctrnn->inputWeights = carveVector(&cursor, ctrnn->numInputNodes);
+    ctrnn->inputs = carveVector(&cursor, ctrnn->numInputNodes);
+    ctrnn->frozenInputs = carveVector(&cursor, ctrnn->numInputNodes);
+    ctrnn->y = carveVector(&cursor, numNodes);
+    ctrnn->output = carveVector(&cursor, numNodes);
+    ctrnn->tempOutput = carveVector(&cursor, numNodes);
+    ctrnn->gain = carveVector(&cursor, numNodes);
+    ctrnn->gainBias = carveVector(&cursor, numNodes);
+    ctrnn->t = carveVector(&cursor, numNodes);
+    ctrnn->rate = carveVector(&cursor, numNodes);
+    ctrnn->sineCoefficient = carveVector(&cursor, numNodes);
+    ctrnn->tanhCoefficient = carveVector(&cursor, numNodes);
+    ctrnn->frequencyMultiplier = carveVector(&cursor, numNodes);
+    
+    // Input Nodes
+    int node;
+    int w;
+    for(node = 0; node < ctrnn->numInputNodes; node++){
+        mapNodeParamsf(ctrnn, node, &configDesc->inputNodes[node]);
+        ctrnn->inputWeights[node] = (float)mapWeight(configDesc->inputNodes[node].weights[0]);
+    }
+    // Hidden Nodes
+    for(node = 0; node < ctrnn->numHiddenNodes; node++){
+        mapNodeParamsf(ctrnn, ctrnn->numInputNodes + node, &configDesc->hiddenNodes[node]);
+        float *row = ctrnn->weights + (size_t)node * numNodes;
+        for(w = 0; w < numNodes; w++){
+            row[w] = (float)mapWeight(configDesc->hiddenNodes[node].weights[w]);
+        }
+    }
+    // Initiliase start state.
+    for(node = 0; node < ctrnn->numInputNodes; node++){
+        ctrnn->inputs[node] = 0.0f;
+    }
+    for(node = 0; node < numNodes; node++){
+        ctrnn->y[node] = 0.0f;
+        ctrnn->output[node] = 1.0f;
+        ctrnn->tempOutput[node] = 0.0f;
+    }
+    thawCTRNNf(ctrnn);
+    ctrnn->initialised = 1;
+}
+// Initialse CTRNN. All of its storage comes from a single allocation.
+void initialiseCTRNNf(CTRNNf *ctrnn, ConfigDesc *configDesc, float timeStep){
+    prepareCTRNNf(ctrnn);
+    layoutCTRNNf(ctrnn, configDesc, timeStep, malloc(ctrnnfRequiredBytes(configDesc)));
+    ctrnn->ownsMemory = 1;
+}
+// Initialse CTRNN inside a caller-provided block. See initialiseCTRNNInPlace.
+void initialiseCTRNNfInPlace(CTRNNf *ctrnn, ConfigDesc *configDesc, float timeStep, void *memory){
+    prepareCTRNNf(ctrnn);
+    layoutCTRNNf(ctrnn, configDesc, timeStep, memory);
+    ctrnn->ownsMemory = 0;
+}
+// Feed CTRNN inputs.
+void feedCTRNNfInputs(CTRNNf *ctrnn, float inputs[]){
+    int iNode;
+    for(iNode = 0; iNode < ctrnn->numInputNodes; iNode++){
+        ctrnn->inputs[iNode] = inputs[iNode];
+    }
+}
+// Update CTRNN state. Out-of-line wrapper of stepCTRNNf.
+void updateCTRNNf(CTRNNf *ctrnn){
+    stepCTRNNf(ctrnn);
+}
+// Render numSteps steps in one call. See renderCTRNNBlock.
+void renderCTRNNfBlock(CTRNNf *ctrnn, const float *inputs, int inputStride, float *outputs, int numOutputNodes, CTRNNOutputLayout layout, int numSteps){
+    int numInputNodes = ctrnn->numInputNodes;
+    int step;
+    int i;
+    for(step = 0; step < numSteps; step++){
+        if(inputs){
+            const float *frame = inputs + (size_t)step * inputStride;
+            for(i = 0; i < numInputNodes; i++){
+                ctrnn->inputs[i] = frame[i];
+            }
+        }
+        stepCTRNNf(ctrnn);
+        const float *hiddenOutput = ctrnn->output + numInputNodes;
+        if(layout == CTRNN_OUTPUT_PLANAR){
+            for(i = 0; i < numOutputNodes; i++){
+                outputs[(size_t)i * numSteps + step] = hiddenOutput[i];
+            }
+        } else {
+            float *frame = outputs + (size_t)step * numOutputNodes;
+            for(i = 0; i < numOutputNodes; i++){
+                frame[i] = hiddenOutput[i];
+            }
+        }
+    }
+}
+// Get CTRNN outputs.
+void getCTRNNfOutput(CTRNNf *ctrnn, float * outputs, int numOutputNodes){
+    const float *hiddenOutput = ctrnn->output + ctrnn->numInputNodes;
+    int i;
+    for (i = 0; i < numOutputNodes; i++) {
+        outputs[i] = hiddenOutput[i];
+    }
+}
+// Reset CTRNN nodes.
+void resetCTRNNf(CTRNNf *ctrnn){
+    int node;
+    for(node = 0; node < ctrnn->numNodes; node++){
+        ctrnn->y[node] = 0;
+        ctrnn->output[node] = 0;
+        ctrnn->tempOutput[node] = 0;
+    }
+    thawCTRNNf(ctrnn);
+}
+// Change CTRNN timestep.
+void changeCTRNNfTimestep(CTRNNf *ctrnn, float timeStep){
+    int node;
+    ctrnn->timeStep = timeStep;
+    for(node = 0; node < ctrnn->numNodes; node++){
+        ctrnn->rate[node] = timeStep / ctrnn->t[node];
+    }
+    thawCTRNNf(ctrnn);
+}
+// Select the instruction set used to step the CTRNN.
+void selectCTRNNfKernels(CTRNNf *ctrnn, CTRNNKernelLevel level){
+    ctrnn->kernels = getCTRNNKernels(level);
+    thawCTRNNf(ctrnn);
+}
+// Freeze the CTRNN on a fixed point. See setCTRNNFreeze.
+void setCTRNNfFreeze(CTRNNf *ctrnn, float threshold, int steps){
+    ctrnn->freezeThreshold = threshold;
+    ctrnn->freezeSteps = steps < 1 ? 1 : steps;
+    thawCTRNNf(ctrnn);
+}
+// Go back to integrating. See thawCTRNN.
+void thawCTRNNf(CTRNNf *ctrnn){
+    ctrnn->settledSteps = 0;
+    ctrnn->frozen = 0;
+}
+// Free memory assigned for CTRNN. Blocks passed to initialiseCTRNNfInPlace stay with the caller.
+void destroyCTRNNf(CTRNNf *ctrnn){
+    if(ctrnn->ownsMemory){
+        free(ctrnn->memory);
+    }
+    ctrnn->memory = NULL;
+    ctrnn->ownsMemory = 0;
+    ctrnn->initialised = 0;
+}
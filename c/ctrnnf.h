@@ -0,0 +1,122 @@
+#ifndef ctrnnf_h
+#define ctrnnf_h
+
+#ifdef __cplusplus 
+extern "C" { 
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctrnn.h"
+
+// Single-precision CTRNN. Same layout and API as CTRNN with float state and
+// parameters, which halves the footprint and doubles the SIMD lane count.
+typedef struct CTRNNf {
+
+    float *weights; // Hidden node weights, row-major (numHiddenNodes x numNodes).
+    float *inputWeights; // Single weight of each input node.
+    float *inputs; // External inputs fed to the input nodes.
+    float *y;
+    float *output; // Outputs of the previous step, shared by all hidden nodes.
+    float *tempOutput; // Next outputs. Swapped with output after each step.
+    float *gain;
+    float *gainBias; // gain * bias, so the activation is gain * y - gainBias.
+    float *t;
+    float *rate; // timeStep / t, refreshed when the timestep changes.
+    float *sineCoefficient;
+    float *tanhCoefficient; // 1 - sineCoefficient.
+    float *frequencyMultiplier;
+    float *frozenInputs; // Inputs the network froze under.
+    float timeStep;
+    float freezeThreshold; // |dy/dt| below which a node counts as settled. 0 turns freezing off.
+    int freezeSteps; // Steps in a row every node must be settled for before the network freezes.
+    int settledSteps; // Steps in a row on which every node was settled.
+    int frozen; // Set while the network rests on a fixed point and steps are skipped.
+    const CTRNNKernels *kernels;
+    int numInputNodes;
+    int numHiddenNodes;
+    int numNodes;
+    void *memory; // Single block holding every vector above.
+    int ownsMemory; // Set when the block was allocated by initialiseCTRNNf.
+    int initialised;
+
+} CTRNNf;
+
+void destroyCTRNNf(CTRNNf *ctrnn);
+
+void resetCTRNNf(CTRNNf *ctrnn);
+
+void changeCTRNNfTimestep(CTRNNf *ctrnn, float timeStep);
+
+void initialiseCTRNNf(CTRNNf *ctrnn, ConfigDesc *configDesc, float timeStep);
+
+size_t ctrnnfRequiredBytes(ConfigDesc *configDesc);
+
+void initialiseCTRNNfInPlace(CTRNNf *ctrnn, ConfigDesc *configDesc, float timeStep, void *memory);
+
+void feedCTRNNfInputs(CTRNNf *ctrnn, float inputs[]);
+
+void getCTRNNfOutput(CTRNNf *ctrnn, float * outputs, int numOutputNodes);
+
+void updateCTRNNf(CTRNNf *ctrnn);
+
+void renderCTRNNfBlock(CTRNNf *ctrnn, const float *inputs, int inputStride, float *outputs, int numOutputNodes, CTRNNOutputLayout layout, int numSteps);
+
+void selectCTRNNfKernels(CTRNNf *ctrnn, CTRNNKernelLevel level);
+
+void setCTRNNfFreeze(CTRNNf *ctrnn, float threshold, int steps);
+
+void thawCTRNNf(CTRNNf *ctrnn);
+
+// Advance every node by one time step. Inline counterpart of updateCTRNNf, see stepCTRNN.
+static inline void stepCTRNNf(CTRNNf *ctrnn){
+    int numInputNodes = ctrnn->numInputNodes;
+    int numNodes = ctrnn->numNodes;
+    float *y = ctrnn->y;
+    float *yDot = ctrnn->tempOutput;
+    int node;
+    if(ctrnn->frozen){
+        for(node = 0; node < numInputNodes && ctrnn->inputs[node] == ctrnn->frozenInputs[node]; node++){
+        }
+        if(node == numInputNodes){
+            return;
+        }
+        ctrnn->frozen = 0;
+    }
+    for(node = 0; node < numInputNodes; node++){
+        yDot[node] = -y[node] + ctrnn->inputs[node] * ctrnn->inputWeights[node];
+    }
+    for(node = numInputNodes; node < numNodes; node++){
+        yDot[node] = -y[node];
+    }
+    ctrnn->kernels->matVecFloat(ctrnn->weights, ctrnn->output, yDot + numInputNodes, ctrnn->numHiddenNodes, numNodes);
+    const float *rate = ctrnn->rate;
+    const float *gain = ctrnn->gain;
+    const float *gainBias = ctrnn->gainBias;
+    if(ctrnn->freezeThreshold > 0){
+        float limit = ctrnn->freezeThreshold * ctrnn->timeStep;
+        for(node = 0; node < numNodes && fabsf(yDot[node] * rate[node]) <= limit; node++){
+        }
+        ctrnn->settledSteps = node == numNodes ? ctrnn->settledSteps + 1 : 0;
+        if(ctrnn->settledSteps >= ctrnn->freezeSteps){
+            for(node = 0; node < numInputNodes; node++){
+                ctrnn->frozenInputs[node] = ctrnn->inputs[node];
+            }
+            ctrnn->settledSteps = 0;
+            ctrnn->frozen = 1;
+        }
+    }
+    for(node = 0; node < numNodes; node++){
+        y[node] += yDot[node] * rate[node];
+        yDot[node] = gain[node] * y[node] - gainBias[node];
+    }
+    ctrnn->kernels->sineTransferFloat(yDot, ctrnn->tanhCoefficient, ctrnn->sineCoefficient, ctrnn->frequencyMultiplier, yDot, numNodes);
+    ctrnn->tempOutput = ctrnn->output;
+    ctrnn->output = yDot;
+}
+
+#ifdef __cplusplus 
+}
+#endif
+
+#endif /* ctrnnf_h */
@@ -3,124 +3,562 @@
 //
 
 #include "jsonUtils.h"
+#include "ctrnn.h"
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
-void renderCTRNNConfigs(ConfigData *configData, char *json){
+// Cursor over a JSON document. Parse functions do nothing once error is set.
+typedef struct JSONStream {
+    const char *cursor;
+    int error;
+} JSONStream;
 
-    int inputNodes = 0;
-    int hiddenNodes = 0;
-    JSON_Value *root_value;
-    JSON_Object *main_object;
-    JSON_Array *config_data;
-    JSON_Array *input_nodes;
-    JSON_Array *hidden_nodes;
+// Position and length of a node's weights in the config's shared weight buffer.
+typedef struct WeightSpan {
+    int offset;
+    int count;
+} WeightSpan;
 
-    /* parsing json and validating output */
-    root_value = json_parse_string(json);
-    
-    main_object = json_value_get_object(root_value);
-    
-    config_data = json_object_get_array(main_object, "configs");
-    int numConfigs = (int)json_object_get_number(main_object, "total");
-    // Initialise config info.
-    initConfigData(configData, numConfigs);
-    // Iterate through configs.
-    int i = 0;
-    for (i = 0; i < numConfigs; i++) {
-        // Get config from array.
-        JSON_Object *config = json_array_get_object(config_data, i);
-        // Get numbers of nodes.
-        int val = (int)json_object_get_number(config, "iNs");
-        inputNodes = val;
-        val = (int)json_object_get_number(config, "hNs");
-        hiddenNodes = val;
-        // Initialise or assign memory for config.
-        initConfigDesc(&configData->configDescriptions[i], inputNodes, hiddenNodes);
-        // Get tag from config. Convert const to char.
-        configData->configDescriptions[i].tag = strdup(json_object_get_string(config, "tag"));
-        // Get input nodes from config.
-        input_nodes = json_object_get_array(config, "inputNodes");
-        int numInputNodes = json_array_get_count(input_nodes);
-        if(numInputNodes != inputNodes){
-            json_value_free(root_value);
-            return;
+// Nodes and weights of the config being parsed. Index 0 holds input nodes, index 1 hidden nodes.
+// The buffers are reused from one config to the next.
+typedef struct ConfigBuilder {
+    ConfigNode *nodes[2];
+    WeightSpan *spans[2];
+    int numNodes[2];
+    int nodeCapacity[2];
+    double *weights;
+    int numWeights;
+    int weightCapacity;
+} ConfigBuilder;
+
+// Grow a buffer so it can hold needed elements.
+static void *growBuffer(void *buffer, int *capacity, int needed, size_t elementSize){
+    if(needed <= *capacity){
+        return buffer;
+    }
+    int newCapacity = *capacity ? *capacity * 2 : 16;
+    while(newCapacity < needed){
+        newCapacity *= 2;
+    }
+    *capacity = newCapacity;
+    return realloc(buffer, elementSize * newCapacity);
+}
+// Skip whitespace before the next token.
+static void skipWhitespace(JSONStream *stream){
+    while(*stream->cursor == ' ' || *stream->cursor == '\n' || *stream->cursor == '\r' || *stream->cursor == '\t'){
+        stream->cursor++;
+    }
+}
+// Consume c if it is the next token.
+static int acceptChar(JSONStream *stream, char c){
+    skipWhitespace(stream);
+    if(*stream->cursor == c){
+        stream->cursor++;
+        return 1;
+    }
+    return 0;
+}
+// Consume c, which must be the next token.
+static void expectChar(JSONStream *stream, char c){
+    if(!stream->error && !acceptChar(stream, c)){
+        stream->error = 1;
+    }
+}
+// Scan a string token without decoding it. Returns the characters between the quotes.
+static const char *scanString(JSONStream *stream, size_t *length){
+    expectChar(stream, '"');
+    if(stream->error){
+        return NULL;
+    }
+    const char *start = stream->cursor;
+    while(*stream->cursor != '"'){
+        if(*stream->cursor == '\0'){
+            stream->error = 1;
+            return NULL;
         }
-        char *params[] = {"bias", "gain", "t", "sineCoefficient", "frequencyMultiplier"};
-        int node;
-        int paramType;
-        for(node = 0; node < numInputNodes; node++){
-            // Get node from array.
-            JSON_Object *inputNode = json_array_get_object(input_nodes, node);
-            // For each param type, get data.
-            for(paramType = 0; paramType < 5; paramType++){
-                double paramVal = json_object_get_number(inputNode, params[paramType]);
-                if(strcmp(params[paramType], "bias") == 0){
-                    configData->configDescriptions[i].inputNodes[node].bias = paramVal;
-                }
-                if(strcmp(params[paramType], "gain") == 0){
-                    configData->configDescriptions[i].inputNodes[node].gain = paramVal;
-                }
-                if(strcmp(params[paramType], "t") == 0){
-                    configData->configDescriptions[i].inputNodes[node].t = paramVal;
-                }
-                if(strcmp(params[paramType], "sineCoefficient") == 0){
-                    configData->configDescriptions[i].inputNodes[node].sineCoefficient = paramVal;
+        if(*stream->cursor == '\\' && stream->cursor[1] != '\0'){
+            stream->cursor++;
+        }
+        stream->cursor++;
+    }
+    *length = stream->cursor - start;
+    stream->cursor++;
+    return start;
+}
+// Parse a string token into a new allocation, decoding escapes.
+static char *parseString(JSONStream *stream){
+    size_t length = 0;
+    const char *start = scanString(stream, &length);
+    if(stream->error){
+        return NULL;
+    }
+    // Decoded strings are never longer than their escaped form.
+    char *string = (char *)malloc(length + 1);
+    char *out = string;
+    const char *in = start;
+    while(in < start + length){
+        if(*in != '\\'){
+            *out++ = *in++;
+            continue;
+        }
+        in++;
+        switch(*in){
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                // Basic multilingual plane code points, encoded as UTF-8.
+                if(start + length - in < 5){
+                    *out++ = *in;
+                    break;
                 }
-                if(strcmp(params[paramType], "frequencyMultiplier") == 0){
-                    configData->configDescriptions[i].inputNodes[node].frequencyMultiplier = paramVal;
+                unsigned int code = (unsigned int)strtoul((char[5]){in[1], in[2], in[3], in[4], '\0'}, NULL, 16);
+                if(code < 0x80){
+                    *out++ = (char)code;
+                } else if(code < 0x800){
+                    *out++ = (char)(0xC0 | (code >> 6));
+                    *out++ = (char)(0x80 | (code & 0x3F));
+                } else {
+                    *out++ = (char)(0xE0 | (code >> 12));
+                    *out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (code & 0x3F));
                 }
+                in += 4;
+                break;
             }
-            // Assign memory for number of weights.
-            configData->configDescriptions[i].inputNodes[node].weights = (double *)malloc(sizeof(double) * 1);
-            // Get weight array. There is always only one for input nodes.
-            JSON_Array *weightArray = json_object_get_array(inputNode, "w");
-            double paramVal = json_array_get_number(weightArray, 0);
-            configData->configDescriptions[i].inputNodes[node].weights[0] = paramVal;
+            default: *out++ = *in; break;
         }
-        // Get hidden nodes from config
-        hidden_nodes = json_object_get_array(config, "hiddenNodes");
-        int numHiddenNodes = json_array_get_count(hidden_nodes);
-        if(numHiddenNodes != hiddenNodes){
-            json_value_free(root_value);
-            return;
+        in++;
+    }
+    *out = '\0';
+    return string;
+}
+// Skip any value, including nested objects and arrays, without decoding it.
+static void skipValue(JSONStream *stream){
+    int depth = 0;
+    skipWhitespace(stream);
+    if(stream->error){
+        return;
+    }
+    const char *cursor = stream->cursor;
+    if(*cursor != '{' && *cursor != '[' && *cursor != '"'){
+        // Numbers and literals run up to the next delimiter.
+        while(*cursor && !strchr(",]} \n\r\t", *cursor)){
+            cursor++;
         }
-        for(node = 0; node < numHiddenNodes; node++){
-            // Get node from array.
-            JSON_Object *hiddenNode = json_array_get_object(hidden_nodes, node);
-            // For each param type, get data.
-            for(paramType = 0; paramType < 5; paramType++){
-                double paramVal = json_object_get_number(hiddenNode, params[paramType]);
-                if(strcmp(params[paramType], "bias") == 0){
-                    configData->configDescriptions[i].hiddenNodes[node].bias = paramVal;
-                }
-                if(strcmp(params[paramType], "gain") == 0){
-                    configData->configDescriptions[i].hiddenNodes[node].gain = paramVal;
-                }
-                if(strcmp(params[paramType], "t") == 0){
-                    configData->configDescriptions[i].hiddenNodes[node].t = paramVal;
-                }
-                if(strcmp(params[paramType], "sineCoefficient") == 0){
-                    configData->configDescriptions[i].hiddenNodes[node].sineCoefficient = paramVal;
-                }
-                if(strcmp(params[paramType], "frequencyMultiplier") == 0){
-                    configData->configDescriptions[i].hiddenNodes[node].frequencyMultiplier = paramVal;
+        stream->error = cursor == stream->cursor;
+        stream->cursor = cursor;
+        return;
+    }
+    // Only strings and brackets matter inside containers.
+    do {
+        switch(*cursor++){
+            case '"':
+                while(*cursor != '"'){
+                    if(*cursor == '\0'){
+                        stream->error = 1;
+                        return;
+                    }
+                    if(*cursor == '\\' && cursor[1] != '\0'){
+                        cursor++;
+                    }
+                    cursor++;
                 }
+                cursor++;
+                break;
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                depth--;
+                break;
+            case '\0':
+                stream->error = 1;
+                return;
+            default:
+                break;
+        }
+    } while(depth > 0);
+    stream->cursor = cursor;
+}
+// Parse a number. Other values count as 0, matching json_object_get_number.
+static double parseNumber(JSONStream *stream){
+    skipWhitespace(stream);
+    if(stream->error){
+        return 0;
+    }
+    char *end;
+    double number = strtod(stream->cursor, &end);
+    if(end == stream->cursor){
+        skipValue(stream);
+        return 0;
+    }
+    stream->cursor = end;
+    return number;
+}
+// Move to the next member of an object, returning 0 at its end. Sets key to the member's name.
+static int nextMember(JSONStream *stream, int *count, const char **key, size_t *keyLength){
+    if(stream->error || acceptChar(stream, '}')){
+        return 0;
+    }
+    if((*count)++ > 0){
+        expectChar(stream, ',');
+    }
+    *key = scanString(stream, keyLength);
+    expectChar(stream, ':');
+    return !stream->error;
+}
+// Move to the next element of an array, returning 0 at its end.
+static int nextElement(JSONStream *stream, int *count){
+    if(stream->error || acceptChar(stream, ']')){
+        return 0;
+    }
+    if((*count)++ > 0){
+        expectChar(stream, ',');
+    }
+    return !stream->error;
+}
+// Check whether a scanned key equals name.
+static int keyIs(const char *key, size_t keyLength, const char *name){
+    return strlen(name) == keyLength && memcmp(key, name, keyLength) == 0;
+}
+// Parse a node object, appending its weights to the builder's weight buffer.
+static void parseNode(JSONStream *stream, ConfigBuilder *builder, ConfigNode *node, WeightSpan *span){
+    const char *key;
+    size_t keyLength;
+    int members = 0;
+    node->bias = 0;
+    node->gain = 0;
+    node->t = 0;
+    node->sineCoefficient = 0;
+    node->frequencyMultiplier = 0;
+    node->weights = NULL;
+    span->offset = builder->numWeights;
+    span->count = 0;
+    expectChar(stream, '{');
+    while(nextMember(stream, &members, &key, &keyLength)){
+        if(keyIs(key, keyLength, "w")){
+            int elements = 0;
+            span->offset = builder->numWeights;
+            span->count = 0;
+            expectChar(stream, '[');
+            while(nextElement(stream, &elements)){
+                builder->weights = (double *)growBuffer(builder->weights, &builder->weightCapacity, builder->numWeights + 1, sizeof(double));
+                builder->weights[builder->numWeights++] = parseNumber(stream);
+                span->count++;
             }
-            // Assign memory for number of weights.
-            int numNodes = inputNodes + hiddenNodes;
-            configData->configDescriptions[i].hiddenNodes[node].weights = (double *)malloc(sizeof(double) * numNodes);
-            // Get weight array.
-            JSON_Array *weightArray = json_object_get_array(hiddenNode, "w");
-            int weight;
-            for(weight = 0; weight < numNodes; weight++){
-                double paramVal = json_array_get_number(weightArray, weight);
-                configData->configDescriptions[i].hiddenNodes[node].weights[weight] = paramVal;
+        } else if(keyIs(key, keyLength, "bias")){
+            node->bias = parseNumber(stream);
+        } else if(keyIs(key, keyLength, "gain")){
+            node->gain = parseNumber(stream);
+        } else if(keyIs(key, keyLength, "t")){
+            node->t = parseNumber(stream);
+        } else if(keyIs(key, keyLength, "sineCoefficient")){
+            node->sineCoefficient = parseNumber(stream);
+        } else if(keyIs(key, keyLength, "frequencyMultiplier")){
+            node->frequencyMultiplier = parseNumber(stream);
+        } else {
+            skipValue(stream);
+        }
+    }
+}
+// Parse an array of nodes into the builder. kind is 0 for input nodes and 1 for hidden nodes.
+static void parseNodes(JSONStream *stream, ConfigBuilder *builder, int kind){
+    int elements = 0;
+    builder->numNodes[kind] = 0;
+    expectChar(stream, '[');
+    while(nextElement(stream, &elements)){
+        int needed = builder->numNodes[kind] + 1;
+        int capacity = builder->nodeCapacity[kind];
+        builder->nodes[kind] = (ConfigNode *)growBuffer(builder->nodes[kind], &capacity, needed, sizeof(ConfigNode));
+        builder->spans[kind] = (WeightSpan *)growBuffer(builder->spans[kind], &builder->nodeCapacity[kind], needed, sizeof(WeightSpan));
+        parseNode(stream, builder, &builder->nodes[kind][builder->numNodes[kind]], &builder->spans[kind][builder->numNodes[kind]]);
+        builder->numNodes[kind]++;
+    }
+}
+// Copy built nodes into a config, giving each node numWeights weights. Missing weights are 0.
+static void copyNodes(ConfigBuilder *builder, int kind, ConfigNode *nodes, int numWeights){
+    int node;
+    int w;
+    for(node = 0; node < builder->numNodes[kind]; node++){
+        WeightSpan span = builder->spans[kind][node];
+        nodes[node] = builder->nodes[kind][node];
+        nodes[node].weights = (double *)malloc(sizeof(double) * numWeights);
+        for(w = 0; w < numWeights; w++){
+            nodes[node].weights[w] = w < span.count ? builder->weights[span.offset + w] : 0;
+        }
+    }
+}
+// Parse a config object into configDesc. Returns 0 if its node counts disagree with iNs and hNs.
+static int parseConfig(JSONStream *stream, ConfigBuilder *builder, ConfigDesc *configDesc){
+    const char *key;
+    size_t keyLength;
+    int members = 0;
+    int inputNodes = 0;
+    int hiddenNodes = 0;
+    char *tag = NULL;
+    builder->numNodes[0] = 0;
+    builder->numNodes[1] = 0;
+    builder->numWeights = 0;
+    expectChar(stream, '{');
+    // Members can come in any order, so nodes are held in the builder until the config ends.
+    while(nextMember(stream, &members, &key, &keyLength)){
+        if(keyIs(key, keyLength, "inputNodes")){
+            parseNodes(stream, builder, 0);
+        } else if(keyIs(key, keyLength, "hiddenNodes")){
+            parseNodes(stream, builder, 1);
+        } else if(keyIs(key, keyLength, "iNs")){
+            inputNodes = (int)parseNumber(stream);
+        } else if(keyIs(key, keyLength, "hNs")){
+            hiddenNodes = (int)parseNumber(stream);
+        } else if(keyIs(key, keyLength, "tag")){
+            free(tag);
+            tag = parseString(stream);
+        } else {
+            skipValue(stream);
+        }
+    }
+    if(stream->error || builder->numNodes[0] != inputNodes || builder->numNodes[1] != hiddenNodes){
+        free(tag);
+        return 0;
+    }
+    initConfigDesc(configDesc, inputNodes, hiddenNodes);
+    configDesc->tag = tag ? tag : strdup("");
+    // Input nodes have a single weight, hidden nodes one per node.
+    copyNodes(builder, 0, configDesc->inputNodes, 1);
+    copyNodes(builder, 1, configDesc->hiddenNodes, inputNodes + hiddenNodes);
+    return 1;
+}
+// Scan a config object without building it, keeping only its tag.
+static int scanConfig(JSONStream *stream, ConfigDesc *configDesc){
+    const char *key;
+    size_t keyLength;
+    int members = 0;
+    char *tag = NULL;
+    expectChar(stream, '{');
+    while(nextMember(stream, &members, &key, &keyLength)){
+        if(keyIs(key, keyLength, "tag")){
+            free(tag);
+            tag = parseString(stream);
+        } else {
+            skipValue(stream);
+        }
+    }
+    if(stream->error){
+        free(tag);
+        return 0;
+    }
+    // Unbuilt configs have no nodes, so destroyConfigDesc only frees their tag.
+    configDesc->inputNodes = NULL;
+    configDesc->hiddenNodes = NULL;
+    configDesc->numInputNodes = 0;
+    configDesc->numHiddenNodes = 0;
+    configDesc->tag = tag ? tag : strdup("");
+    configDesc->mapped = NULL;
+    return 1;
+}
+// Free the buffers of a config builder.
+static void destroyConfigBuilder(ConfigBuilder *builder){
+    free(builder->nodes[0]);
+    free(builder->nodes[1]);
+    free(builder->spans[0]);
+    free(builder->spans[1]);
+    free(builder->weights);
+}
+// Parse the profile JSON into configData in a single pass. Lazy parsing only records where each config starts.
+static void renderConfigs(ConfigData *configData, char *json, int lazy){
+    JSONStream stream = {json, 0};
+    ConfigBuilder builder = {{NULL, NULL}, {NULL, NULL}, {0, 0}, {0, 0}, NULL, 0, 0};
+    ConfigDesc *configs = NULL;
+    size_t *offsets = NULL;
+    int numConfigs = 0;
+    int configCapacity = 0;
+    int offsetCapacity = 0;
+    int total = -1;
+    int valid = 1;
+    const char *key;
+    size_t keyLength;
+    int members = 0;
+    if(configData->initialised == 1){
+        destroyConfigData(configData);
+    }
+    expectChar(&stream, '{');
+    while(nextMember(&stream, &members, &key, &keyLength)){
+        if(keyIs(key, keyLength, "configs")){
+            int elements = 0;
+            expectChar(&stream, '[');
+            while(valid && nextElement(&stream, &elements)){
+                configs = (ConfigDesc *)growBuffer(configs, &configCapacity, numConfigs + 1, sizeof(ConfigDesc));
+                if(lazy){
+                    skipWhitespace(&stream);
+                    offsets = (size_t *)growBuffer(offsets, &offsetCapacity, numConfigs + 1, sizeof(size_t));
+                    offsets[numConfigs] = stream.cursor - json;
+                    valid = scanConfig(&stream, &configs[numConfigs]);
+                } else {
+                    valid = parseConfig(&stream, &builder, &configs[numConfigs]);
+                }
+                numConfigs += valid;
             }
+        } else if(keyIs(key, keyLength, "total")){
+            total = (int)parseNumber(&stream);
+        } else {
+            skipValue(&stream);
         }
     }
-    
-    json_value_free(root_value);
+    destroyConfigBuilder(&builder);
+    configData->configDescriptions = configs;
+    configData->numConfigs = numConfigs;
+    configData->json = lazy ? json : NULL;
+    configData->jsonOffsets = offsets;
+    configData->tagIndex = NULL;
+    configData->tagIndexSize = 0;
+    if(!valid || stream.error){
+        // Leave configData empty rather than half parsed.
+        destroyConfigData(configData);
+        configData->configDescriptions = NULL;
+        configData->numConfigs = 0;
+        return;
+    }
+    // Only the first total configs are used, as before.
+    for(; total >= 0 && configData->numConfigs > total; configData->numConfigs--){
+        destroyConfigDesc(&configs[configData->numConfigs - 1]);
+    }
+    buildConfigTagIndex(configData);
     configData->initialised = 1;
 }
+// Parse the profile JSON straight into configData in a single pass, without building a DOM.
+void renderCTRNNConfigs(ConfigData *configData, char *json){
+    renderConfigs(configData, json, 0);
+}
+// Index the configs in the profile JSON and read their tags, but build each config only when
+// getConfigDesc first asks for it. json is read in place and must outlive configData.
+void renderCTRNNConfigsLazy(ConfigData *configData, char *json){
+    renderConfigs(configData, json, 1);
+}
+// Build a lazily rendered config in place. Returns 0 if it does not parse.
+static int buildConfig(ConfigData *configData, int index, ConfigBuilder *builder){
+    ConfigDesc *configDesc = &configData->configDescriptions[index];
+    JSONStream stream = {configData->json + configData->jsonOffsets[index], 0};
+    ConfigDesc built;
+    if(!parseConfig(&stream, builder, &built)){
+        return 0;
+    }
+    free(configDesc->tag);
+    *configDesc = built;
+    configData->jsonOffsets[index] = CONFIG_BUILT;
+    return 1;
+}
+// Get a config by index, building it first if it was rendered lazily. Returns NULL if index is out
+// of range or the config does not parse. Not thread-safe while configs are still being built.
+ConfigDesc *getConfigDesc(ConfigData *configData, int index){
+    if(index < 0 || index >= configData->numConfigs){
+        return NULL;
+    }
+    if(configData->jsonOffsets && configData->jsonOffsets[index] != CONFIG_BUILT){
+        ConfigBuilder builder = {{NULL, NULL}, {NULL, NULL}, {0, 0}, {0, 0}, NULL, 0, 0};
+        int valid = buildConfig(configData, index, &builder);
+        destroyConfigBuilder(&builder);
+        if(!valid){
+            return NULL;
+        }
+    }
+    return &configData->configDescriptions[index];
+}
+// Get the first config with the given tag, building it if needed. Returns NULL if there is none.
+ConfigDesc *getConfigDescByTag(ConfigData *configData, const char *tag){
+    int config = findConfigIndexByTag(configData, tag);
+    return config >= 0 ? getConfigDesc(configData, config) : NULL;
+}
+
+// Configs handed to a worker at a time. Small enough to balance configs of different sizes.
+#define PARSE_CHUNK_CONFIGS 32
+
+// Work shared by the parsing threads.
+typedef struct ParseWork {
+    ConfigData *configData;
+    int nextConfig; // Next unclaimed config, advanced atomically.
+    int failed; // Set atomically when any config does not parse.
+    int map; // Whether each config is mapped with mapCTRNNConfig once built.
+} ParseWork;
+
+// Claim chunks of configs and build them, and map them if asked, into their own slots until none are left.
+static void *parseWorker(void *argument){
+    ParseWork *work = (ParseWork *)argument;
+    ConfigBuilder builder = {{NULL, NULL}, {NULL, NULL}, {0, 0}, {0, 0}, NULL, 0, 0};
+    int first;
+    int config;
+    while((first = __atomic_fetch_add(&work->nextConfig, PARSE_CHUNK_CONFIGS, __ATOMIC_RELAXED)) < work->configData->numConfigs){
+        int last = first + PARSE_CHUNK_CONFIGS < work->configData->numConfigs ? first + PARSE_CHUNK_CONFIGS : work->configData->numConfigs;
+        for(config = first; config < last; config++){
+            if(!buildConfig(work->configData, config, &builder)){
+                __atomic_store_n(&work->failed, 1, __ATOMIC_RELAXED);
+            } else if(work->map){
+                mapCTRNNConfig(&work->configData->configDescriptions[config]);
+            }
+        }
+    }
+    destroyConfigBuilder(&builder);
+    return NULL;
+}
+// Parse the profile JSON on numThreads threads (0 for one per core). A structural scan finds every
+// config and reads its tag first, then the threads build them, mapping each if map is set.
+static void renderConfigsParallel(ConfigData *configData, char *json, int numThreads, int map){
+    renderConfigs(configData, json, 1);
+    if(!configData->initialised){
+        return;
+    }
+    ParseWork work = {configData, 0, 0, map};
+#if defined(_WIN32)
+    // No pthreads, so build on the calling thread.
+    (void)numThreads;
+    parseWorker(&work);
+#else
+    if(numThreads <= 0){
+        numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    int maxThreads = (configData->numConfigs + PARSE_CHUNK_CONFIGS - 1) / PARSE_CHUNK_CONFIGS;
+    numThreads = numThreads < maxThreads ? numThreads : maxThreads;
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * (numThreads > 1 ? numThreads - 1 : 1));
+    int thread;
+    int started = 0;
+    // The calling thread works too.
+    for(thread = 0; thread < numThreads - 1; thread++){
+        started += pthread_create(&threads[started], NULL, parseWorker, &work) == 0;
+    }
+    parseWorker(&work);
+    for(thread = 0; thread < started; thread++){
+        pthread_join(threads[thread], NULL);
+    }
+    free(threads);
+#endif
+    if(work.failed){
+        // Leave configData empty rather than half parsed.
+        destroyConfigData(configData);
+        configData->configDescriptions = NULL;
+        configData->numConfigs = 0;
+        return;
+    }
+    // Every config is built, so the source text is no longer needed.
+    free(configData->jsonOffsets);
+    configData->jsonOffsets = NULL;
+    configData->json = NULL;
+}
+// Parse the profile JSON on numThreads threads (0 for one per core). The threads build the configs
+// into their own slots, so the result matches renderCTRNNConfigs.
+void renderCTRNNConfigsParallel(ConfigData *configData, char *json, int numThreads){
+    renderConfigsParallel(configData, json, numThreads, 0);
+}
+// As renderCTRNNConfigsParallel, but each thread also maps the configs it builds, so the result
+// matches renderCTRNNConfigs followed by mapCTRNNConfigs.
+void renderAndMapCTRNNConfigsParallel(ConfigData *configData, char *json, int numThreads){
+    renderConfigsParallel(configData, json, numThreads, 1);
+}
 
 char * extractConfigData(char *json){
 
@@ -138,3 +576,14 @@ char * extractConfigData(char *json){
     json_value_free(root_value);
     return modified;
 }
+// Convert profile JSON to a binary config file for openConfigBinary. Returns 0 if the JSON does not parse or the file cannot be written.
+int convertCTRNNConfigsToBinary(char *json, const char *path){
+    ConfigData configData = {NULL, 0, 0, NULL, NULL, NULL, 0};
+    renderCTRNNConfigs(&configData, json);
+    if(!configData.initialised){
+        return 0;
+    }
+    int written = writeConfigBinary(&configData, path);
+    destroyConfigData(&configData);
+    return written;
+}
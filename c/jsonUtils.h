@@ -14,12 +14,25 @@ extern "C" {
 #include <string.h>
 #include "parson.h"			// include JSON parser
 #include "ctrnnConfig.h"
+#include "configBinary.h"
     
 
 void renderCTRNNConfigs(ConfigData *configData, char *json);
+
+void renderCTRNNConfigsLazy(ConfigData *configData, char *json);
+
+void renderCTRNNConfigsParallel(ConfigData *configData, char *json, int numThreads);
+
+void renderAndMapCTRNNConfigsParallel(ConfigData *configData, char *json, int numThreads);
+
+ConfigDesc *getConfigDesc(ConfigData *configData, int index);
+
+ConfigDesc *getConfigDescByTag(ConfigData *configData, const char *tag);
     
 char * extractConfigData(char *json);
 
+int convertCTRNNConfigsToBinary(char *json, const char *path);
+
 #ifdef __cplusplus 
 }
 #endif
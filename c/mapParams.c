@@ -50,6 +50,98 @@ double sineTransferFunction(double activation, double sineCoefficient, double fr
     return (1 - sineCoefficient) * tanh(activation) + sineCoefficient * sin(frequencyMiltiplier * activation);
 }
 
+float sineTransferFunctionf(float activation, float sineCoefficient, float frequencyMiltiplier){
+    return (1 - sineCoefficient) * tanhf(activation) + sineCoefficient * sinf(frequencyMiltiplier * activation);
+}
+
+// Fast approximation. tanh is a [7/6] Pade approximant clamped to [-1, 1] (max error 9.7e-5)
+// and sin a degree 9 Taylor polynomial after reduction to [-pi/2, pi/2] (max error 3.6e-6).
+double fastTanh(double x){
+    x = x > 5.0 ? 5.0 : (x < -5.0 ? -5.0 : x);
+    double x2 = x * x;
+    double r = x * (135135.0 + x2 * (17325.0 + x2 * (378.0 + x2))) / (135135.0 + x2 * (62370.0 + x2 * (3150.0 + x2 * 28.0)));
+    return r > 1.0 ? 1.0 : (r < -1.0 ? -1.0 : r);
+}
+
+double fastSin(double x){
+    // NaN, infinities and arguments too large to reduce would overflow the integer conversion.
+    if(!(fabs(x) < 1e15)){
+        return sin(x);
+    }
+    // Adding 1.5 * 2^52 rounds to the nearest integer.
+    double n = (x * 0.3183098861837907 + 6755399441055744.0) - 6755399441055744.0;
+    double r = (x - n * 3.141592502593994) - n * 1.5099578831723193e-07;
+    double rr = r * r;
+    double s = r + r * rr * (-0.16666666666666666 + rr * (0.008333333333333333 + rr * (-0.0001984126984126984 + rr * 2.7557319223985893e-06)));
+    return ((long long)n & 1) ? -s : s;
+}
+
+double fastSineTransferFunction(double activation, double sineCoefficient, double frequencyMiltiplier){
+    return (1 - sineCoefficient) * fastTanh(activation) + sineCoefficient * fastSin(frequencyMiltiplier * activation);
+}
+
+// Lookup tables with linear interpolation. tanh is tabulated on [0, 8] and mirrored
+// (max error 1.5e-6), sin over one period (max error 1.2e-6).
+#define TANH_TABLE_SIZE 2048
+#define TANH_TABLE_RANGE 8.0
+#define SINE_TABLE_SIZE 2048
+#define TWO_PI 6.283185307179586
+
+static double tanhTable[TANH_TABLE_SIZE + 2];
+static double sineTable[SINE_TABLE_SIZE + 1];
+// 0 before the tables are filled, 1 while one thread fills them and 2 once they are ready.
+static int transferTablesState = 0;
+
+// Fill the lookup tables. Call before the first tableSineTransferFunction, off the audio thread.
+// Safe to call from several threads at once: one fills the tables and the others wait for it.
+void initialiseTransferTables(void){
+    int expected = 0;
+    if(__atomic_load_n(&transferTablesState, __ATOMIC_ACQUIRE) == 2){
+        return;
+    }
+    if(!__atomic_compare_exchange_n(&transferTablesState, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)){
+        while(__atomic_load_n(&transferTablesState, __ATOMIC_ACQUIRE) != 2){
+        }
+        return;
+    }
+    int i;
+    for(i = 0; i <= TANH_TABLE_SIZE; i++){
+        tanhTable[i] = tanh(i * (TANH_TABLE_RANGE / TANH_TABLE_SIZE));
+    }
+    // Guard entry so the clamped top of the range interpolates to tanh(8).
+    tanhTable[TANH_TABLE_SIZE + 1] = tanhTable[TANH_TABLE_SIZE];
+    for(i = 0; i <= SINE_TABLE_SIZE; i++){
+        sineTable[i] = sin(i * (TWO_PI / SINE_TABLE_SIZE));
+    }
+    __atomic_store_n(&transferTablesState, 2, __ATOMIC_RELEASE);
+}
+
+double tableTanh(double x){
+    if(x != x){
+        return x;
+    }
+    double ax = fabs(x);
+    double position = (ax < TANH_TABLE_RANGE ? ax : TANH_TABLE_RANGE) * (TANH_TABLE_SIZE / TANH_TABLE_RANGE);
+    int i = (int)position;
+    double v = tanhTable[i] + (position - i) * (tanhTable[i + 1] - tanhTable[i]);
+    return x < 0 ? -v : v;
+}
+
+double tableSin(double x){
+    double position = x * (SINE_TABLE_SIZE / TWO_PI);
+    // NaN, infinities and positions too large for the integer conversion.
+    if(!(fabs(position) < 1e15)){
+        return sin(x);
+    }
+    double base = floor(position);
+    int i = (int)((long long)base & (SINE_TABLE_SIZE - 1));
+    return sineTable[i] + (position - base) * (sineTable[i + 1] - sineTable[i]);
+}
+
+double tableSineTransferFunction(double activation, double sineCoefficient, double frequencyMiltiplier){
+    return (1 - sineCoefficient) * tableTanh(activation) + sineCoefficient * tableSin(frequencyMiltiplier * activation);
+}
+
 double transferFunction(double activation){
     return tanh(activation);
 }
@@ -25,6 +25,22 @@ double mapSineCoefficient(double paramValue);
 double mapFrequencyMultiplier(double paramValue);
 
 double sineTransferFunction(double activation, double sineCoefficient, double frequencyMiltiplier);
+
+float sineTransferFunctionf(float activation, float sineCoefficient, float frequencyMiltiplier);
+
+double fastTanh(double x);
+
+double fastSin(double x);
+
+double tableTanh(double x);
+
+double tableSin(double x);
+
+double fastSineTransferFunction(double activation, double sineCoefficient, double frequencyMiltiplier);
+
+double tableSineTransferFunction(double activation, double sineCoefficient, double frequencyMiltiplier);
+
+void initialiseTransferTables(void);
     
 double transferFunction(double activation);
 
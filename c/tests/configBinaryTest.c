@@ -0,0 +1,224 @@
+//
+//  Writes a binary config file, loads it back, and checks that truncated files and hand-crafted
+//  hostile headers and records are rejected by openConfigBinary rather than read out of bounds.
+//
+
+#include <stdint.h>
+#include <string.h>
+#include "configBinary.h"
+
+static const char *path = "configBinaryTest.plcb";
+static const char *hostilePath = "configBinaryTestHostile.plcb";
+
+// Field offsets of the file layout described in configBinary.c.
+#define HEADER_NUM_CONFIGS 12
+#define HEADER_NUM_NODES 16
+#define HEADER_CONFIG_OFFSET 24
+#define HEADER_NODE_OFFSET 32
+#define HEADER_WEIGHT_OFFSET 40
+#define HEADER_TAG_OFFSET 48
+#define HEADER_FILE_SIZE 56
+#define RECORD_NUM_INPUT_NODES 0
+#define RECORD_NUM_HIDDEN_NODES 4
+#define RECORD_FIRST_NODE 8
+#define RECORD_WEIGHT_OFFSET 16
+#define RECORD_TAG_OFFSET 24
+
+static int failures = 0;
+
+static void check(int condition, const char *description){
+    if(!condition){
+        printf("FAILED: %s\n", description);
+        failures++;
+    }
+}
+// Fill a config with values that identify each node and weight.
+static void fillConfig(ConfigDesc *configDesc, int numInputNodes, int numHiddenNodes, const char *tag, double base){
+    int numNodes = numInputNodes + numHiddenNodes;
+    int node;
+    int w;
+    initConfigDesc(configDesc, numInputNodes, numHiddenNodes);
+    for(node = 0; node < numNodes; node++){
+        ConfigNode *configNode = node < numInputNodes ? &configDesc->inputNodes[node] : &configDesc->hiddenNodes[node - numInputNodes];
+        int numWeights = node < numInputNodes ? 1 : numNodes;
+        configNode->gain = base + node * 0.01;
+        configNode->bias = base + node * 0.02;
+        configNode->t = base + node * 0.03;
+        configNode->sineCoefficient = base + node * 0.04;
+        configNode->frequencyMultiplier = base + node * 0.05;
+        configNode->weights = (double *)malloc(sizeof(double) * numWeights);
+        for(w = 0; w < numWeights; w++){
+            configNode->weights[w] = base + node * 0.1 + w * 0.001;
+        }
+    }
+    configDesc->tag = (char *)malloc(strlen(tag) + 1);
+    strcpy(configDesc->tag, tag);
+}
+// Whether two configs hold the same parameters, weights and tag.
+static int sameConfig(ConfigDesc *a, ConfigDesc *b){
+    int numNodes = a->numInputNodes + a->numHiddenNodes;
+    int node;
+    int w;
+    if(a->numInputNodes != b->numInputNodes || a->numHiddenNodes != b->numHiddenNodes || strcmp(a->tag, b->tag) != 0){
+        return 0;
+    }
+    for(node = 0; node < numNodes; node++){
+        ConfigNode *nodeA = node < a->numInputNodes ? &a->inputNodes[node] : &a->hiddenNodes[node - a->numInputNodes];
+        ConfigNode *nodeB = node < b->numInputNodes ? &b->inputNodes[node] : &b->hiddenNodes[node - b->numInputNodes];
+        int numWeights = node < a->numInputNodes ? 1 : numNodes;
+        if(nodeA->gain != nodeB->gain || nodeA->bias != nodeB->bias || nodeA->t != nodeB->t
+           || nodeA->sineCoefficient != nodeB->sineCoefficient || nodeA->frequencyMultiplier != nodeB->frequencyMultiplier){
+            return 0;
+        }
+        for(w = 0; w < numWeights; w++){
+            if(nodeA->weights[w] != nodeB->weights[w]){
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+// Read a whole file into memory.
+static char *readFile(const char *name, size_t *size){
+    FILE *file = fopen(name, "rb");
+    if(!file){
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = (char *)malloc(*size);
+    if(fread(data, 1, *size, file) != *size){
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+// Write size bytes of data to hostilePath and report whether openConfigBinary accepts it.
+static int opens(const char *data, size_t size){
+    FILE *file = fopen(hostilePath, "wb");
+    ConfigBinary binary = {0};
+    fwrite(data, 1, size, file);
+    fclose(file);
+    if(!openConfigBinary(&binary, hostilePath)){
+        return 0;
+    }
+    closeConfigBinary(&binary);
+    return 1;
+}
+static void put32(char *data, size_t offset, uint32_t value){
+    memcpy(data + offset, &value, sizeof(value));
+}
+static void put64(char *data, size_t offset, uint64_t value){
+    memcpy(data + offset, &value, sizeof(value));
+}
+static uint64_t get64(const char *data, size_t offset){
+    uint64_t value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+// Copy of the valid file with one 32 or 64 bit field replaced, checked to be rejected.
+static void checkRejected32(const char *data, size_t size, size_t offset, uint32_t value, const char *description){
+    char *copy = (char *)malloc(size);
+    memcpy(copy, data, size);
+    put32(copy, offset, value);
+    check(!opens(copy, size), description);
+    free(copy);
+}
+static void checkRejected64(const char *data, size_t size, size_t offset, uint64_t value, const char *description){
+    char *copy = (char *)malloc(size);
+    memcpy(copy, data, size);
+    put64(copy, offset, value);
+    check(!opens(copy, size), description);
+    free(copy);
+}
+
+int main(void){
+    ConfigData configData = {0};
+    ConfigBinary binary = {0};
+    size_t size = 0;
+    int config;
+    initConfigData(&configData, 2);
+    configData.initialised = 1;
+    fillConfig(&configData.configDescriptions[0], 2, 3, "first", 1.0);
+    fillConfig(&configData.configDescriptions[1], 4, 6, "second", 2.0);
+
+    // A written file loads back unchanged.
+    check(writeConfigBinary(&configData, path), "write the binary config file");
+    check(openConfigBinary(&binary, path), "open the binary config file");
+    if(binary.initialised){
+        check(binary.configData.numConfigs == 2, "number of configs");
+        for(config = 0; config < 2 && binary.configData.numConfigs == 2; config++){
+            check(sameConfig(&configData.configDescriptions[config], &binary.configData.configDescriptions[config]), "configs load back unchanged");
+        }
+        closeConfigBinary(&binary);
+    }
+
+    // Views can be edited in place, and the edits never reach the file.
+    if(openConfigBinary(&binary, path)){
+        ConfigDesc *view = &binary.configData.configDescriptions[1];
+        view->hiddenNodes[0].weights[0] = -7.0;
+        view->tag[0] = 'S';
+        check(view->hiddenNodes[0].weights[0] == -7.0 && strcmp(view->tag, "Second") == 0, "views can be edited in place");
+        closeConfigBinary(&binary);
+    }
+    check(openConfigBinary(&binary, path), "open the binary config file again");
+    if(binary.initialised){
+        check(sameConfig(&configData.configDescriptions[1], &binary.configData.configDescriptions[1]), "edits to views leave the file unchanged");
+        closeConfigBinary(&binary);
+    }
+    char *data = readFile(path, &size);
+    check(data != NULL && size > 64, "read the binary config file");
+    if(!data){
+        return EXIT_FAILURE;
+    }
+
+    // Truncated files, as they are and with the header's file size patched to match.
+    size_t length;
+    int truncatedOpened = 0;
+    for(length = 0; length < size; length++){
+        char *truncated = (char *)malloc(size);
+        memcpy(truncated, data, size);
+        truncatedOpened += opens(truncated, length);
+        if(length >= HEADER_FILE_SIZE + sizeof(uint64_t)){
+            put64(truncated, HEADER_FILE_SIZE, length);
+            truncatedOpened += opens(truncated, length);
+        }
+        free(truncated);
+    }
+    check(truncatedOpened == 0, "truncated files are rejected");
+
+    // Hostile headers. Counts that wrap the size checks, and offsets past the end of the file.
+    uint64_t nodeOffset = get64(data, HEADER_NODE_OFFSET);
+    checkRejected64(data, size, HEADER_NUM_NODES, UINT64_MAX / 40 + 2, "node count that wraps nodeOffset + nodes");
+    checkRejected64(data, size, HEADER_NUM_NODES, UINT64_MAX, "node count of UINT64_MAX");
+    checkRejected32(data, size, HEADER_NUM_CONFIGS, UINT32_MAX, "config count of UINT32_MAX");
+    checkRejected32(data, size, HEADER_NUM_CONFIGS, 0x7fffffff, "config count of INT_MAX");
+    checkRejected64(data, size, HEADER_CONFIG_OFFSET, UINT64_MAX - 7, "config offset that wraps");
+    checkRejected64(data, size, HEADER_NODE_OFFSET, UINT64_MAX - 7, "node offset that wraps");
+    checkRejected64(data, size, HEADER_WEIGHT_OFFSET, UINT64_MAX - 63, "weight offset that wraps");
+    checkRejected64(data, size, HEADER_TAG_OFFSET, UINT64_MAX, "tag offset past the file");
+    checkRejected64(data, size, HEADER_FILE_SIZE, size + 1, "file size that disagrees with the file");
+
+    // Hostile records, in the second config's record.
+    size_t record = (size_t)get64(data, HEADER_CONFIG_OFFSET) + 32;
+    checkRejected32(data, size, record + RECORD_NUM_HIDDEN_NODES, UINT32_MAX, "hidden node count of UINT32_MAX");
+    checkRejected32(data, size, record + RECORD_NUM_INPUT_NODES, 0x80000000u, "input node count over INT_MAX");
+    checkRejected32(data, size, record + RECORD_NUM_HIDDEN_NODES, 0x20000000u, "hidden node count whose weights wrap");
+    checkRejected64(data, size, record + RECORD_FIRST_NODE, UINT64_MAX - 2, "first node that wraps");
+    checkRejected64(data, size, record + RECORD_FIRST_NODE, (size - nodeOffset) / 40, "first node past the node table");
+    checkRejected64(data, size, record + RECORD_WEIGHT_OFFSET, UINT64_MAX - 7, "weight offset that wraps");
+    checkRejected64(data, size, record + RECORD_WEIGHT_OFFSET, get64(data, HEADER_TAG_OFFSET) - get64(data, HEADER_WEIGHT_OFFSET) - 8, "weights that run into the tags");
+    checkRejected64(data, size, record + RECORD_TAG_OFFSET, UINT64_MAX, "tag offset that wraps");
+    checkRejected64(data, size, record + RECORD_TAG_OFFSET, size, "tag offset past the file");
+
+    free(data);
+    destroyConfigData(&configData);
+    remove(path);
+    remove(hostilePath);
+    if(failures == 0){
+        printf("binary config loader: all checks passed\n");
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
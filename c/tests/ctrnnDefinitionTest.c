@@ -0,0 +1,74 @@
+//
+//  Re-initialises instances with the definition they already hold, after the creator's reference
+//  is gone, and checks that the definition survives and the instances step like an owned CTRNN.
+//  Build with PLECTO_SANITIZE=address to catch a definition freed too early.
+//
+
+#include <string.h>
+#include "ctrnn.h"
+#include "syntheticConfig.h"
+
+#define NUM_STEPS 1000
+
+static int failures = 0;
+
+static void check(int condition, const char *description){
+    if(!condition){
+        printf("FAILED: %s\n", description);
+        failures++;
+    }
+}
+// Whether ctrnn and reference give the same hidden outputs over NUM_STEPS steps.
+static int stepsLike(CTRNN *ctrnn, CTRNN *reference){
+    double inputs[4] = {0.5, 0.5, 0.5, 0.5};
+    double outputs[6];
+    double referenceOutputs[6];
+    int step;
+    feedCTRNNInputs(ctrnn, inputs);
+    feedCTRNNInputs(reference, inputs);
+    for(step = 0; step < NUM_STEPS; step++){
+        updateCTRNN(ctrnn);
+        updateCTRNN(reference);
+        getCTRNNOutput(ctrnn, outputs, 6);
+        getCTRNNOutput(reference, referenceOutputs, 6);
+        if(memcmp(outputs, referenceOutputs, sizeof(outputs)) != 0){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void){
+    ConfigDesc configDesc;
+    CTRNN reference = {0};
+    CTRNN instance = {0};
+    CTRNN inPlace = {0};
+    buildSyntheticConfig(&configDesc, 4, 6, 1);
+    initialiseCTRNN(&reference, &configDesc, 0.02);
+
+    // The README pattern: the instance holds the only reference once the creator's is released.
+    CTRNNDefinition *definition = createCTRNNDefinition(&configDesc);
+    initialiseCTRNNInstance(&instance, definition, 0.01);
+    releaseCTRNNDefinition(definition);
+    initialiseCTRNNInstance(&instance, instance.definition, 0.02);
+    check(instance.definition == definition && definition->refCount == 1, "instance keeps its definition when re-initialised with it");
+    check(stepsLike(&instance, &reference), "re-initialised instance steps like an owned CTRNN");
+
+    // The same in place, sharing the definition with the first instance.
+    void *memory = malloc(ctrnnInstanceRequiredBytes(definition));
+    initialiseCTRNNInstanceInPlace(&inPlace, definition, 0.01, memory);
+    destroyCTRNN(&instance);
+    initialiseCTRNNInstanceInPlace(&inPlace, inPlace.definition, 0.02, memory);
+    check(inPlace.definition == definition && definition->refCount == 1, "in-place instance keeps its definition when re-initialised with it");
+    initialiseCTRNN(&reference, &configDesc, 0.02);
+    check(stepsLike(&inPlace, &reference), "re-initialised in-place instance steps like an owned CTRNN");
+
+    destroyCTRNN(&inPlace);
+    free(memory);
+    destroyCTRNN(&reference);
+    destroyConfigDesc(&configDesc);
+    if(failures == 0){
+        printf("definition re-initialisation: all checks passed\n");
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+//
+//  Runs CTRNNf next to CTRNN over long runs of non-chaotic configs and fails when any hidden
+//  output differs by more than maxDivergence. The configs are chosen here, from the first
+//  NUM_SEEDS synthetic configs, by how the double engine responds to a small nudge every step.
+//
+
+#include <float.h>
+#include <math.h>
+#include "ctrnnf.h"
+#include "syntheticConfig.h"
+
+#define NUM_STEPS 100000
+#define TIME_STEP 0.01
+#define NUM_SEEDS 128
+// Fewest configs the search must find for the test to mean anything.
+#define MIN_CONFIGS 3
+// Added to every node's y before every step of the nudged run.
+static const double nudge = 1e-9;
+// The float engine rounds each node's y every step, a persistent error of about FLT_EPSILON.
+// A config whose outputs move by no more than nudge * NUM_STEPS under a nudge every step lets
+// such errors add up at most linearly, so its float outputs stay within NUM_STEPS * FLT_EPSILON.
+static const double maxDivergence = NUM_STEPS * FLT_EPSILON;
+
+// Largest hidden output difference over NUM_STEPS steps between a network and a copy nudged every
+// step. Stops early once it exceeds nudge * NUM_STEPS.
+static double nudgeResponse(ConfigDesc *configDesc){
+    CTRNN ctrnn = {0};
+    CTRNN nudged = {0};
+    double inputs[4] = {0.5, 0.5, 0.5, 0.5};
+    double outputs[6];
+    double nudgedOutputs[6];
+    double response = 0;
+    int step;
+    int node;
+    initialiseCTRNN(&ctrnn, configDesc, TIME_STEP);
+    initialiseCTRNN(&nudged, configDesc, TIME_STEP);
+    feedCTRNNInputs(&ctrnn, inputs);
+    feedCTRNNInputs(&nudged, inputs);
+    for(step = 0; step < NUM_STEPS && response <= nudge * NUM_STEPS; step++){
+        for(node = 0; node < nudged.numNodes; node++){
+            nudged.y[node] += nudge;
+        }
+        updateCTRNN(&ctrnn);
+        updateCTRNN(&nudged);
+        getCTRNNOutput(&ctrnn, outputs, 6);
+        getCTRNNOutput(&nudged, nudgedOutputs, 6);
+        for(node = 0; node < 6; node++){
+            response = fmax(response, fabs(outputs[node] - nudgedOutputs[node]));
+        }
+    }
+    destroyCTRNN(&ctrnn);
+    destroyCTRNN(&nudged);
+    return response;
+}
+// Largest hidden output difference between the two engines over NUM_STEPS steps with kernels level.
+static double divergence(ConfigDesc *configDesc, CTRNNKernelLevel level){
+    CTRNN ctrnn = {0};
+    CTRNNf ctrnnf = {0};
+    double inputs[4] = {0.5, 0.5, 0.5, 0.5};
+    float inputsf[4] = {0.5f, 0.5f, 0.5f, 0.5f};
+    double outputs[6];
+    float outputsf[6];
+    double difference = 0;
+    int step;
+    int node;
+    initialiseCTRNN(&ctrnn, configDesc, TIME_STEP);
+    initialiseCTRNNf(&ctrnnf, configDesc, (float)TIME_STEP);
+    selectCTRNNKernels(&ctrnn, level);
+    selectCTRNNfKernels(&ctrnnf, level);
+    feedCTRNNInputs(&ctrnn, inputs);
+    feedCTRNNfInputs(&ctrnnf, inputsf);
+    for(step = 0; step < NUM_STEPS; step++){
+        updateCTRNN(&ctrnn);
+        updateCTRNNf(&ctrnnf);
+        getCTRNNOutput(&ctrnn, outputs, 6);
+        getCTRNNfOutput(&ctrnnf, outputsf, 6);
+        for(node = 0; node < 6; node++){
+            difference = fmax(difference, fabs(outputs[node] - outputsf[node]));
+        }
+    }
+    destroyCTRNN(&ctrnn);
+    destroyCTRNNf(&ctrnnf);
+    return difference;
+}
+
+int main(void){
+    static const CTRNNKernelLevel levels[] = {CTRNN_KERNELS_SCALAR, CTRNN_KERNELS_AUTO};
+    static const char *levelNames[] = {"scalar", "auto"};
+    int numConfigs = 0;
+    int failures = 0;
+    unsigned int seed;
+    int level;
+    for(seed = 1; seed <= NUM_SEEDS; seed++){
+        ConfigDesc configDesc;
+        buildSyntheticConfig(&configDesc, 4, 6, seed);
+        if(nudgeResponse(&configDesc) <= nudge * NUM_STEPS){
+            numConfigs++;
+            for(level = 0; level < 2; level++){
+                double difference = divergence(&configDesc, levels[level]);
+                int failed = !(difference <= maxDivergence);
+                printf("seed %3u %-6s max output difference %.3g of %.3g%s\n", seed, levelNames[level], difference, maxDivergence, failed ? " FAILED" : "");
+                failures += failed;
+            }
+        }
+        destroyConfigDesc(&configDesc);
+    }
+    if(numConfigs < MIN_CONFIGS){
+        printf("FAILED: only %d of %d configs are non-chaotic, %d needed\n", numConfigs, NUM_SEEDS, MIN_CONFIGS);
+        failures++;
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+//
+//  Synthetic configs for the tests, built from a seed the way the benchmarks build theirs.
+//
+
+#ifndef syntheticConfig_h
+#define syntheticConfig_h
+
+#include "ctrnnConfig.h"
+
+// Deterministic values in [0, 1), the range configs are serialised in.
+static double nextValue(unsigned int *seed){
+    *seed = *seed * 1664525u + 1013904223u;
+    return (*seed >> 8) / 16777216.0;
+}
+static void fillConfigNode(ConfigNode *node, int numWeights, unsigned int *seed){
+    int w;
+    node->gain = nextValue(seed);
+    node->bias = nextValue(seed);
+    node->t = nextValue(seed);
+    node->sineCoefficient = nextValue(seed);
+    node->frequencyMultiplier = nextValue(seed);
+    node->weights = (double *)malloc(sizeof(double) * numWeights);
+    for(w = 0; w < numWeights; w++){
+        node->weights[w] = nextValue(seed);
+    }
+}
+// Build a synthetic config, as the benchmarks do. Release it with destroyConfigDesc.
+static void buildSyntheticConfig(ConfigDesc *configDesc, int numInputNodes, int numHiddenNodes, unsigned int seed){
+    int node;
+    initConfigDesc(configDesc, numInputNodes, numHiddenNodes);
+    for(node = 0; node < numInputNodes; node++){
+        fillConfigNode(&configDesc->inputNodes[node], 1, &seed);
+    }
+    for(node = 0; node < numHiddenNodes; node++){
+        fillConfigNode(&configDesc->hiddenNodes[node], numInputNodes + numHiddenNodes, &seed);
+    }
+}
+
+#endif /* syntheticConfig_h */